@@ -1,11 +1,75 @@
 #include "elfParser.h"
 #include "elfReader.h"
+#include "elfBatch.h"
+#include "streamReader.h"
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
 using namespace std;
+
+void Usage() {
+    cout << "Usage: elf2Link <input file|->" << endl;
+    cout << "       elf2Link [-j <threads>] [-m <max in flight>] "
+         << "-b <directory|file list|->" << endl;
+}
+
+void PrintLink(const FileLikeReader& f, int symbolThreads, ostream& out) {
+    // We only print the file, so there's no need to re-build the tables
+    ElfParserOptions options;
+    options.lazy = true;
+    options.symbolThreads = symbolThreads;
+    ElfParser p(f, options);
+    out << p.PrintLink() << endl;
+}
+
 int main(int argc, const char *argv[])
 {
-    ElfFileReader f(argv[1]);
-    ElfParser p(f);
-    cout << p.PrintLink() << endl;
+    ElfBatchOptions batch;
+    int first = 0;
+    try {
+        first = ElfBatch::ParseOptions(argc, argv, batch);
+    } catch ( const string& error ) {
+        cout << error << endl;
+        Usage();
+        return 1;
+    }
+
+    if ( batch.Batch() ) {
+        if ( first != argc ) {
+            Usage();
+            return 1;
+        }
+        // The files are already being done in parallel, so each one only
+        // gets a single thread
+        ElfBatch::Job job = [] (const string& input, ostream& out) {
+            ElfFileReader f(input);
+            PrintLink(f, 1, out);
+        };
+        try {
+            vector<string> inputs = ElfBatch::Inputs(batch.source);
+            size_t failed = ElfBatch(batch).Run(inputs, job, cout, cerr);
+            return failed ? 2 : 0;
+        } catch ( const string& error ) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+
+    if ( argc != 2 ) {
+        Usage();
+        return 1;
+    }
+
+    // "-" reads the file from stdin, so we can sit at the end of a pipe
+    unique_ptr<FileLikeReader> f;
+    if ( string(argv[1]) == "-" ) {
+        f.reset(new StreamReader(STDIN_FILENO));
+    } else {
+        f.reset(new ElfFileReader(argv[1]));
+    }
+
+    PrintLink(*f, std::thread::hardware_concurrency(), cout);
     return 0;
 }
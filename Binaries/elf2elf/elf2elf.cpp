@@ -1,17 +1,87 @@
 #include "elfParser.h"
 #include "elfReader.h"
+#include "elfBatch.h"
 #include <iostream>
 #include "buildElf.h"
-#include "stdWriter.h"
+#include "logger.h"
 #include <sstream>
 #include <elf.h>
 #include <memory>
 #include <string>
+#include <thread>
 
 using namespace std;
 
+void Usage() {
+    cout << "Usage: elf2elf <input file> <output file=<input file>.out" << endl;
+    cout << "       elf2elf [-j <threads>] [-m <max in flight>] "
+         << "-b <directory|file list|->" << endl;
+    cout << "  (batch mode writes each <input file> to <input file>.out)"
+         << endl;
+    cout << "  (a directory's non-ELF files, and earlier outputs, are skipped)"
+         << endl;
+}
+
+// Batch mode writes each file next to its input, with this suffix
+static const string OUTPUT_SUFFIX = ".out";
+
+void Rewrite( const string& inputFile,
+              const string& outputFile,
+              int threads,
+              ostream& out)
+{
+    // Map the input into memorry: we're going to copy all of it
+    ElfFileReader f(inputFile.c_str(), ElfFileReader::READ_SEQUENTIAL);
+    ElfParserOptions options;
+    options.symbolThreads = threads;
+    options.mergeStringTables = true;
+    ElfParser p(f, options);
+
+    ElfFile file( p.Content());
+    SLOG_FROM(LOG_VERBOSE, "elf2elf",
+              outputFile << ": " << file.WastedBytes() << " of "
+                         << file.Size() << " bytes are padding")
+
+    // Sections are copied straight from the input mapping to the output
+    file.WriteToFile(outputFile, threads);
+
+    out << "Re-wrote " << inputFile << " to " << outputFile << endl;
+}
+
 int main(int argc, const char *argv[])
 {
+    ElfBatchOptions batch;
+    int first = 0;
+    try {
+        first = ElfBatch::ParseOptions(argc, argv, batch);
+    } catch ( const string& error ) {
+        cout << error << endl;
+        Usage();
+        return 1;
+    }
+
+    if ( batch.Batch() ) {
+        if ( first != argc ) {
+            Usage();
+            return 1;
+        }
+        // The files are already being done in parallel, so each one only
+        // gets a single thread
+        ElfBatch::Job job = [] (const string& input, ostream& out) {
+            Rewrite(input, input + OUTPUT_SUFFIX, 1, out);
+        };
+        try {
+            // Leave last run's outputs alone, rather than re-writing them
+            vector<string> inputs = ElfBatch::Inputs( batch.source,
+                                                      OUTPUT_SUFFIX);
+            size_t failed = ElfBatch(batch).Run(inputs, job, cout, cerr);
+            return failed ? 2 : 0;
+        } catch ( const string& error ) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+
     string inputFile ="";
     string outputFile ="";
     if ( argc != 3 ) {
@@ -19,7 +89,7 @@ int main(int argc, const char *argv[])
             inputFile = argv[1];
             outputFile = inputFile + ".out";
         } else {
-            cout << "Usage: elf2elf <input file> <output file=<input file>.out" << endl;
+            Usage();
             return 1;
         }
     } else {
@@ -27,21 +97,7 @@ int main(int argc, const char *argv[])
         outputFile = argv[2];
     }
 
-    // Map the input into memorry
-    ElfFileReader f(inputFile.c_str());
-    // Create the output file
-    OFStreamWriter of(outputFile.c_str());
-
-    ElfParser p(f);
-    
-    ElfFile file( p.Content());
-
-    file.WriteToFile(of);
-    
-    // Output the data
-    BinaryReader readPos(BinaryWriter(of));
-
-    cout << "Re-wrote " << inputFile << " to " << outputFile << endl;
+    Rewrite(inputFile, outputFile, std::thread::hardware_concurrency(), cout);
 
     return 0;
 }
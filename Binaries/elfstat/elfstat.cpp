@@ -0,0 +1,93 @@
+#include "headerScanner.h"
+#include "elfReader.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+/*
+ * Print a one line summary of each ELF file on the command line:
+ *
+ *   <file> <type> <machine> entry=<address> segments=<# load>/<# phdrs> \
+ *          sections=<#> [symtab] [debug]
+ *
+ * Only the headers are read, so this is cheap enough to run over a whole
+ * tree of objects.
+ */
+
+using namespace std;
+
+const char* TypeName(Elf64_Half type) {
+    switch ( type ) {
+        case ET_REL:  return "REL";
+        case ET_EXEC: return "EXEC";
+        case ET_DYN:  return "DYN";
+        case ET_CORE: return "CORE";
+        default:      return "UNKNOWN";
+    }
+}
+
+string MachineName(Elf64_Half machine) {
+    switch ( machine ) {
+        case EM_X86_64:  return "x86-64";
+        case EM_386:     return "i386";
+        case EM_AARCH64: return "aarch64";
+        default:         return "machine-" + to_string(machine);
+    }
+}
+
+void Summarise(const string& path, const ElfHeaderScanner& scan) {
+    size_t loads = 0;
+    for ( size_t i = 0; i < scan.Segments(); ++i ) {
+        if ( scan.Segment(i).p_type == PT_LOAD ) ++loads;
+    }
+
+    char entry[32];
+    snprintf(entry, sizeof(entry), "0x%lx",
+             static_cast<unsigned long>(scan.EntryAddress()));
+
+    cout << path << " " << TypeName(scan.Type());
+    cout << " " << MachineName(scan.Machine());
+    cout << " entry=" << entry;
+    cout << " segments=" << loads << "/" << scan.Segments();
+    cout << " sections=" << scan.Sections();
+    if ( scan.HasSection(".symtab") ) cout << " symtab";
+    if ( scan.HasSection(".debug_info") ) cout << " debug";
+    cout << "\n";
+}
+
+int main(int argc, const char *argv[])
+{
+    if ( argc < 2 ) {
+        cout << "Usage: elfstat <file> [<file> ...]" << endl;
+        return 1;
+    }
+
+    int failed = 0;
+    auto start = chrono::steady_clock::now();
+    for ( int i = 1; i < argc; ++i ) {
+        try {
+            // Only the first few pages are wanted: don't read ahead
+            ElfFileReader f(argv[i], ElfFileReader::READ_RANDOM);
+            ElfHeaderScanner scan(f);
+            Summarise(argv[i], scan);
+        } catch ( const string& error ) {
+            cerr << argv[i] << ": " << error << endl;
+            ++failed;
+        } catch ( const char* error ) {
+            cerr << argv[i] << ": " << error << endl;
+            ++failed;
+        }
+    }
+    cout.flush();
+    auto end = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(end - start).count();
+    cerr << "Scanned " << argc - 1 << " files in " << seconds << "s";
+    if ( seconds > 0 ) {
+        cerr << " (" << (argc - 1) / seconds << " files/s)";
+    }
+    cerr << endl;
+
+    return failed ? 2 : 0;
+}
@@ -4,6 +4,7 @@
 #include <map>
 #include <string>
 #include "binaryReader.h"
+#include "nameView.h"
 
 using namespace std;
 
@@ -25,6 +26,7 @@ public:
         Member (const BinaryReader &p);
         virtual ~Member();
         string Name() const { return string(name); }
+        NameView NameRef() const { return NameView(name); }
         long Size() const { 
             return fileSize + sizeof(header);
         }
@@ -0,0 +1,60 @@
+#ifndef NAME_VIEW_H
+#define NAME_VIEW_H
+#include <string>
+#include <cstring>
+#include <ostream>
+
+using namespace std;
+
+/**
+    \class   NameView
+    \brief   Non-owning reference to a name held somewhere else
+    \details A pointer and a length: typically into a string table in a
+             mapped file. Copying, comparing and printing a NameView never
+             allocates.
+
+             The view is only valid for as long as the memory it refers
+             to, ToString() takes an owned copy.
+*/
+class NameView {
+public:
+    NameView(): str(""), len(0) {}
+    NameView(const char* s, size_t l): str(s), len(l) {}
+    NameView(const char* s): str(s), len(strlen(s)) {}
+    NameView(const string& s): str(s.c_str()), len(s.length()) {}
+
+    const char* Data() const { return str; }
+    size_t Length() const { return len; }
+    bool Empty() const { return len == 0; }
+
+    char operator[](size_t i) const { return str[i]; }
+    const char* begin() const { return str; }
+    const char* end() const { return str + len; }
+
+    string ToString() const { return string(str,len); }
+
+    bool operator==(const NameView& rhs) const {
+        return len == rhs.len && memcmp(str, rhs.str, len) == 0;
+    }
+    bool operator!=(const NameView& rhs) const { return !(*this == rhs); }
+
+    // Avoid building a temporary view for literals
+    bool operator==(const char* rhs) const {
+        return strncmp(str, rhs, len) == 0 && rhs[len] == '\0';
+    }
+    bool operator!=(const char* rhs) const { return !(*this == rhs); }
+
+    bool operator<(const NameView& rhs) const {
+        int cmp = memcmp(str, rhs.str, len < rhs.len ? len : rhs.len);
+        return cmp < 0 || (cmp == 0 && len < rhs.len);
+    }
+
+private:
+    const char* str;
+    size_t len;
+};
+
+inline ostream& operator<<(ostream& os, const NameView& name) {
+    return os.write(name.Data(), name.Length());
+}
+#endif
@@ -0,0 +1,128 @@
+#include "addressIndex.h"
+#include "section.h"
+#include "programHeader.h"
+#include <algorithm>
+
+AddressIndex::AddressIndex() {
+}
+
+AddressIndex::AddressIndex(const vector<Section*>& sections) {
+    AddSections(sections);
+}
+
+AddressIndex::AddressIndex( const vector<Section*>& sections,
+                            const vector<ProgramHeader*>& progHeaders)
+{
+    AddSections(sections);
+
+    for ( size_t i = 0; i < progHeaders.size(); ++i ) {
+        const ProgramHeader& segment = *progHeaders[i];
+        if ( segment.IsLoadableSegment() ) {
+            segments.Add(segment.Address(), segment.AddrEnd(), i);
+        }
+    }
+    segments.Sort();
+}
+
+void AddressIndex::AddSections(const vector<Section*>& sections) {
+    for ( size_t i = 0; i < sections.size(); ++i ) {
+        const Section& sec = *sections[i];
+        byOffset.Add(sec.DataStart(), sec.DataEnd(), i);
+        if ( sec.IsNull() || sec.DataSize() == 0 ) {
+            continue;
+        }
+        if ( sec.Address() != 0 ) {
+            byAddress.Add(sec.Address(), sec.AddrEnd(), i);
+        }
+        if ( sec.HasFileData() ) {
+            fileData.Add(sec.DataStart(), sec.DataEnd(), i);
+            if ( sec.Address() != 0 ) {
+                loadedData.Add(sec.Address(), sec.AddrEnd(), i);
+            }
+        }
+    }
+    byOffset.Sort();
+    byAddress.Sort();
+    fileData.Sort();
+    loadedData.Sort();
+}
+
+long AddressIndex::SegmentAt(Elf64_Addr addr) const {
+    return segments.Find(addr);
+}
+
+long AddressIndex::SectionAt(Elf64_Addr addr) const {
+    return byAddress.Find(addr);
+}
+
+long AddressIndex::SectionAtOffset(Elf64_Off offset) const {
+    return fileData.Find(offset);
+}
+
+long AddressIndex::FirstSectionIn(Elf64_Addr start, Elf64_Addr end) const {
+    auto it = loadedData.From(start);
+    if ( it != loadedData.End() && it->start < end ) {
+        return it->item;
+    }
+    return NOT_FOUND;
+}
+
+vector<size_t> AddressIndex::SectionsWithin( Elf64_Off start,
+                                             Elf64_Off end) const
+{
+    vector<size_t> found;
+    for ( auto it = byOffset.From(start);
+          it != byOffset.End() && it->start <= end;
+          ++it )
+    {
+        if ( it->end <= end ) {
+            found.push_back(it->item);
+        }
+    }
+    sort(found.begin(), found.end());
+    return found;
+}
+
+void AddressIndex::Intervals::Add( Elf64_Addr start,
+                                   Elf64_Addr end,
+                                   size_t item)
+{
+    Interval interval = { start, end, item };
+    intervals.push_back(interval);
+}
+
+void AddressIndex::Intervals::Sort() {
+    stable_sort(intervals.begin(), intervals.end(),
+        [] (const Interval& lhs, const Interval& rhs) -> bool {
+            return lhs.start < rhs.start;
+        });
+
+    maxEnd.resize(intervals.size());
+    Elf64_Addr furthest = 0;
+    for ( size_t i = 0; i < intervals.size(); ++i ) {
+        furthest = max(furthest, intervals[i].end);
+        maxEnd[i] = furthest;
+    }
+}
+
+vector<AddressIndex::Intervals::Interval>::const_iterator
+    AddressIndex::Intervals::From(Elf64_Addr point) const
+{
+    return lower_bound(intervals.begin(), intervals.end(), point,
+        [] (const Interval& i, Elf64_Addr p) { return i.start < p; });
+}
+
+long AddressIndex::Intervals::Find(Elf64_Addr point) const {
+    // The last interval to start at or before point...
+    auto it = upper_bound(intervals.begin(), intervals.end(), point,
+        [] (Elf64_Addr p, const Interval& i) { return p < i.start; });
+
+    // ...or, if intervals overlap, possibly one before it
+    for ( size_t i = it - intervals.begin(); i > 0 && maxEnd[i-1] > point; ) {
+        --i;
+        if ( point < intervals[i].end ) {
+            return intervals[i].item;
+        }
+    }
+    return NOT_FOUND;
+}
@@ -0,0 +1,90 @@
+#ifndef ADDRESS_INDEX_H
+#define ADDRESS_INDEX_H
+#include <elf.h>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+class Section;
+class ProgramHeader;
+
+/**
+    \class   AddressIndex
+    \brief   Find the segment or section that covers an address or a file
+             offset
+    \details Each query is a binary search over the sections (or loadable
+             segments) sorted by where they start, rather than a scan of
+             every one. Results are positions in the arrays the index was
+             built from.
+
+             The index is a snapshot: rebuild it if the sections or
+             segments are moved.
+*/
+class AddressIndex {
+public:
+    static const long NOT_FOUND = -1;
+
+    AddressIndex();
+    AddressIndex(const vector<Section*>& sections);
+    AddressIndex( const vector<Section*>& sections,
+                  const vector<ProgramHeader*>& segments);
+
+    // The loadable segment whose memory image holds addr
+    long SegmentAt(Elf64_Addr addr) const;
+
+    // The section loaded at addr
+    long SectionAt(Elf64_Addr addr) const;
+
+    // The section whose data is at offset in the file
+    long SectionAtOffset(Elf64_Off offset) const;
+
+    // Of the sections with file data starting in [start, end), the one
+    // with the lowest address
+    long FirstSectionIn(Elf64_Addr start, Elf64_Addr end) const;
+
+    /*
+     * Every section (whether or not it has any data) that lies within
+     * [start, end] of the file, in ascending order.
+     */
+    vector<size_t> SectionsWithin(Elf64_Off start, Elf64_Off end) const;
+
+private:
+    /*
+     * [start, end) intervals, sorted by start. maxEnd[i] is the furthest
+     * end of intervals[0..i], so a search for a point can stop walking
+     * back as soon as nothing earlier could reach it.
+     */
+    class Intervals {
+    public:
+        void Add(Elf64_Addr start, Elf64_Addr end, size_t item);
+        void Sort();
+
+        long Find(Elf64_Addr point) const;
+
+        struct Interval {
+            Elf64_Addr start;
+            Elf64_Addr end;
+            size_t     item;
+        };
+        // The first interval starting at or after point
+        vector<Interval>::const_iterator From(Elf64_Addr point) const;
+        vector<Interval>::const_iterator End() const {
+            return intervals.end();
+        }
+    private:
+        vector<Interval> intervals;
+        vector<Elf64_Addr> maxEnd;
+    };
+
+    void AddSections(const vector<Section*>& sections);
+
+    Intervals segments;
+    Intervals byAddress;
+    Intervals fileData;
+    // Sections with file data, by address
+    Intervals loadedData;
+    // Including empty sections, and those without any data
+    Intervals byOffset;
+};
+#endif
@@ -0,0 +1,53 @@
+#include "blockCopy.h"
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__)
+    #define BLOCK_COPY_X86
+    #include <immintrin.h>
+#endif
+
+#ifdef BLOCK_COPY_X86
+
+/*
+ * SSE2 (always available on x86_64): 64 bytes per iteration, with the
+ * stores aligned to 16 bytes as _mm_stream_si128 requires.
+ */
+__attribute__((target("sse2")))
+static void StreamCopy(char* dest, const char* src, size_t size) {
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(dest) & 15)) & 15;
+    memcpy(dest, src, head);
+    dest += head;
+    src += head;
+    size -= head;
+
+    for ( ; size >= 64; size -= 64, dest += 64, src += 64 ) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(src);
+        __m128i* out = reinterpret_cast<__m128i*>(dest);
+        __m128i a = _mm_loadu_si128(in);
+        __m128i b = _mm_loadu_si128(in + 1);
+        __m128i c = _mm_loadu_si128(in + 2);
+        __m128i d = _mm_loadu_si128(in + 3);
+        _mm_stream_si128(out, a);
+        _mm_stream_si128(out + 1, b);
+        _mm_stream_si128(out + 2, c);
+        _mm_stream_si128(out + 3, d);
+    }
+    memcpy(dest, src, size);
+
+    // Non-temporal stores are weakly ordered: make sure they're visible
+    // before anyone (e.g. munmap, or another thread) looks
+    _mm_sfence();
+}
+
+#endif
+
+void BlockCopy(void* dest, const void* src, size_t size) {
+#ifdef BLOCK_COPY_X86
+    if ( size >= STREAMING_COPY_MIN ) {
+        StreamCopy(static_cast<char*>(dest), static_cast<const char*>(src), size);
+        return;
+    }
+#endif
+    memcpy(dest, src, size);
+}
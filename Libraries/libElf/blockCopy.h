@@ -0,0 +1,18 @@
+#ifndef BLOCK_COPY_H
+#define BLOCK_COPY_H
+#include <cstddef>
+
+/*
+ * Copies of at least this many bytes bypass the cache
+ */
+static const size_t STREAMING_COPY_MIN = 1024 * 1024;
+
+/*
+ * memcpy, except that large blocks are written with non-temporal stores.
+ *
+ * When writing out a big file, the destination won't be read again any
+ * time soon: pulling it through the cache would only evict the source.
+ * dest and src must not overlap.
+ */
+void BlockCopy(void* dest, const void* src, size_t size);
+#endif
@@ -1,21 +1,48 @@
 #include "buildElf.h"
 #include "logger.h"
 #include "programHeader.h"
+#include "elfReader.h"
+#include "blockCopy.h"
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
-
-
+#include <thread>
+#include <exception>
+
+/*
+ * Below this many bytes per thread, it isn't worth the cost of starting
+ * a new thread to copy them
+ */
+static const Elf64_Xword MIN_BYTES_PER_THREAD = 4 * 1024 * 1024;
+
+static Elf64_Off AlignTo(Elf64_Off offset, Elf64_Xword alignment) {
+    if ( alignment == 0 ) {
+        return offset;
+    }
+    return ((offset + alignment - 1) / alignment) * alignment;
+}
 
 ElfFile::ElfFile(ElfContent& data) 
      : 
-       offsets(data),
        header(data.progHeaders.size() > 0 ? 
                  ElfHeaderX86_64::NewExecutable() :
                  ElfHeaderX86_64::NewObjectFile()),
-       file(1024) , 
-       dataSectionStart(file),
-       sectionHeadersStart(file)
+       sourceData(NULL),
+       sourceFd(-1),
+       dataSectionStart(0),
+       sectionHeadersStart(0),
+       fileSize(0)
 {
+    const ElfFileReader* mapped = dynamic_cast<const ElfFileReader*>(data.source);
+    if ( mapped ) {
+        sourceData = mapped->Data();
+        sourceFd = mapped->Fd();
+    }
+
     InitialiseHeader(data);
     InitialiseFile(data);
       
@@ -23,21 +50,26 @@ ElfFile::ElfFile(ElfContent& data)
     ProcessProgHeaders( data);
 
     
-    sectionHeadersStart.Offset() = WriteDataSections(data);
+    PlaceDataSections(data);
+
+    sectionHeadersStart = offsets.Append(
+        header.Sections() * header.SectionHeaderSize(),
+        alignof(Elf64_Shdr));
 
     Bootstrap(data);
 
-    header.SectionTableStart() = sectionHeadersStart.Offset();
+    header.SectionTableStart() = sectionHeadersStart;
 
 
     WriteSectionHeaders(data);
 
-    // Finally write the header
-    file.Writer().Write(&header,header.Size());
+    // Finally the header, which goes over the top of anything at the start
+    AddExtent(Extent::FILE_HEADER, 0, header.Size());
 
-    // clean up any extra data
-    file.Resize( (long)sectionHeadersStart + 
-                 header.Sections() * header.SectionHeaderSize() );
+    fileSize =   sectionHeadersStart
+               + header.Sections() * header.SectionHeaderSize();
+
+    PlanPieces();
 }
 
 void ElfFile::InitialiseFile(ElfContent& data) {
@@ -45,24 +77,15 @@ void ElfFile::InitialiseFile(ElfContent& data) {
     long programHeadersLength =   data.progHeaders.size()
                                 * header.ProgramHeaderSize();
 
-    dataSectionStart.Offset() =   header.ProgramHeadersStart()
-                                + programHeadersLength;
-                         
-    // Reserve space for data, plus room for alignment 
-    // ( the idea is to allocate too much and resize back down )
-    long sectionDataLength = 0;
-
-    // guess the length of the sectionDataLength
-    for( auto section : data.sections)
-        sectionDataLength += section->Size();
+    dataSectionStart =   header.ProgramHeadersStart()
+                       + programHeadersLength;
+    if ( header.ProgramHeaders() == 0 ) {
+        dataSectionStart = header.Size();
+    }
 
-    long sectionHeadersLength =   header.SectionHeaderSize()
-                                * header.Sections();
+    offsets.Plan(data, dataSectionStart);
 
-    file.Resize(  dataSectionStart.Offset()
-                + sectionDataLength
-                + sectionHeadersLength);
-    file.Fill(0,'\0',file.Size());
+    extents.reserve(data.sections.size() + 3);
 }
 
 void ElfFile::InitialiseHeader(ElfContent &data) {
@@ -120,9 +143,6 @@ void ElfFile::WriteProgHeaders (
                      ElfContent& data,
                      vector<ProgramHeader *>& headers)
 {
-    // Track the position at the head of the file to write headers to
-    BinaryWriter headerPos(file,header.ProgramHeadersStart());
-
     // We're responsible for writing the program headers...
     vector<ProgramHeader*>::iterator it = headers.begin();
     ProgramHeader* ph = *it;
@@ -131,6 +151,7 @@ void ElfFile::WriteProgHeaders (
         ph->FileSize() = headers.size() * ph->Size();
     }
 
+    progHeaderTable.reserve(headers.size());
 
     for (;
          it != headers.end();
@@ -140,16 +161,16 @@ void ElfFile::WriteProgHeaders (
 
         ph->DataStart() = offsets.AddressToOffset(ph->Address());
 
-        headerPos << ph->RawHeader();
+        progHeaderTable.push_back(ph->RawHeader());
     }
+
+    AddExtent(Extent::PROGRAM_HEADERS,
+              header.ProgramHeadersStart(),
+              progHeaderTable.size() * sizeof(Elf64_Phdr));
 }
 
-BinaryWriter ElfFile::WriteDataSections( ElfContent& data)
+void ElfFile::PlaceDataSections( ElfContent& data)
 {
-    // First write
-    BinaryWriter dataWritePos(dataSectionStart);
-    dataWritePos.Offset() = offsets.EndOfMapped();
-
     for ( int i =0; i< header.Sections(); i++ ) {
         Section& sec = *(data.sections[i]);
         if (   sec.HasFileData()
@@ -158,34 +179,26 @@ BinaryWriter ElfFile::WriteDataSections( ElfContent& data)
             if ( sec.IsNull() ) {
                 sec.DataStart() = 0;
                 SLOG_FROM (LOG_VERBOSE,
-                           "ElfFile::WriteDataSections",
+                           "ElfFile::PlaceDataSections",
                            "Not Writing section (no data) : " << i)
-            } else {
-                if ( sec.Address() != 0 )
-                {
-                    sec.DataStart() = offsets.AddressToOffset(sec.Address());
-                    BinaryWriter writePos(dataSectionStart);
-                    writePos.Offset() = sec.DataStart();
-                    sec.WriteRawData(writePos);
-                    SLOG_FROM (LOG_VERBOSE,
-                               "ElfFile::WriteDataSections",
-                               "Writing section (at address ) : " << i)
-                }
-                else
-                {
-                    if ( sec.Alignment() != 0 )  {
-                        dataWritePos.Offset() =
-                            dataWritePos.NextBoundrary(sec.Alignment());
-                    }
-                    sec.DataStart() = dataWritePos.Offset();
-                    sec.WriteRawData(dataWritePos);
-                    dataWritePos.Offset() += sec.DataSize();
-                    SLOG_FROM (LOG_VERBOSE,
-                               "ElfFile::WriteDataSections",
-                               "Writing section (tacked on end) : " << i)
-                }
+                continue;
+            }
+
+            if ( sec.Address() != 0 && offsets.IsMapped(sec.Address()) )
+            {
+                PlaceSection(sec, offsets.AddressToOffset(sec.Address()));
+                SLOG_FROM (LOG_VERBOSE,
+                           "ElfFile::PlaceDataSections",
+                           "Writing section (at address ) : " << i)
+            }
+            else
+            {
+                PlaceSection(sec, offsets.Append(sec.DataSize(),
+                                                 sec.Alignment()));
+                SLOG_FROM (LOG_VERBOSE,
+                           "ElfFile::PlaceDataSections",
+                           "Writing section (tacked on end) : " << i)
             }
-            dataWritePos = (long)dataWritePos + sec.DataSize();
         }
     }
 
@@ -194,39 +207,30 @@ BinaryWriter ElfFile::WriteDataSections( ElfContent& data)
         Section& sec = *(data.sections[i]);
         if (sec.IsRelocTable() && sec.Address() == 0)
         {
-            // Align start position
-            if ( sec.Alignment() != 0 )  {
-                dataWritePos.Offset() = 
-                    dataWritePos.NextBoundrary(sec.Alignment());
-            }
-
-            sec.DataStart() = dataWritePos;
-            sec.WriteRawData(dataWritePos);
-            dataWritePos.Offset() = dataWritePos + sec.DataSize();
+            PlaceSection(sec, offsets.Append(sec.DataSize(), sec.Alignment()));
             SLOG_FROM (LOG_VERBOSE,
-                       "ElfFile::WriteDataSections",
+                       "ElfFile::PlaceDataSections",
                        "Writing reloc table: " << i)
         }
     }
-
-    return dataWritePos;
 }
 
 bool ElfFile::IsSpecialSection(Section& s) {
     bool special = false;
-    special |= s.Name() == ".shstrtab";
-    special |= s.Name() == ".symtab";
-    special |= s.Name() == ".strtab";
+    NameView name = s.NameRef();
+    special |= name == ".shstrtab";
+    special |= name == ".symtab";
+    special |= name == ".strtab";
     return special;
 }
 
 void ElfFile::WriteSectionHeaders(ElfContent &data ) {
-    auto writer = sectionHeadersStart;
+    sectionHeaderTable.reserve(data.sections.size());
     long idx = 0;
     // Write the standard header sections
     for ( Section* sec : data.sections ) {
         if ( ! IsSpecialSection( *sec ) ) {
-            writer << (Elf64_Shdr) *sec;
+            sectionHeaderTable.push_back(*sec);
             ++idx;
         }
     }
@@ -234,27 +238,370 @@ void ElfFile::WriteSectionHeaders(ElfContent &data ) {
     /**
      * These have to be in a specific order at the end of the file...
      */
-    WriteSpecial(data, ".shstrtab" ,idx, writer);
-    WriteSpecial(data, ".symtab", idx, writer);
-    WriteSpecial(data, ".strtab", idx, writer);
+    WriteSpecial(data, ".shstrtab" ,idx);
+    WriteSpecial(data, ".symtab", idx);
+    WriteSpecial(data, ".strtab", idx);
+
+    AddExtent(Extent::SECTION_HEADERS,
+              sectionHeadersStart,
+              sectionHeaderTable.size() * sizeof(Elf64_Shdr));
 }
 
-void ElfFile::WriteSpecial(ElfContent& data, string name,
-                                             long& idx,
-                                             BinaryWriter& writer) {
+void ElfFile::WriteSpecial(ElfContent& data, string name, long& idx) {
     if ( name == ".shstrtab" )  {
         this->header.StringTableIndex() = idx;
     }
-    auto loc = data.sectionMap.find(name);
-    if ( loc != data.sectionMap.end() ) {
-        const Elf64_Shdr& sec = *data.sections[loc->second];
-        writer << sec;
+    int loc = data.sectionMap.Find(name);
+    if ( loc != NameIndex::NOT_FOUND ) {
+        const Elf64_Shdr& sec = *data.sections[loc];
+        sectionHeaderTable.push_back(sec);
         ++idx;
     }
 }
 
+void ElfFile::AddExtent(Extent::Source source,
+                        Elf64_Off offset,
+                        Elf64_Xword size,
+                        const Section* section)
+{
+    Extent extent = { source, offset, size, section, 0 };
+    extents.push_back(extent);
+}
+
+void ElfFile::PlaceSection(Section& sec, Elf64_Off offset) {
+    Extent extent = {
+        Extent::SECTION_DATA,
+        offset,
+        sec.RawDataSize(),
+        &sec,
+        sec.SourceOffset()
+    };
+    extents.push_back(extent);
+    sec.DataStart() = offset;
+}
+
+/*
+ * Work out which bytes of each extent actually make it into the file:
+ * anything placed later hides whatever it overlaps, and nothing past the
+ * section table is kept.
+ */
+void ElfFile::PlanPieces() {
+    pieces.clear();
+    vector<Piece> visible;
+    for ( size_t i = 0; i < extents.size(); ++i ) {
+        const Extent& extent = extents[i];
+        Elf64_Off start = extent.offset;
+        Elf64_Off end = min<Elf64_Off>(start + extent.size, fileSize);
+        if ( start >= end ) {
+            continue;
+        }
+
+        visible.clear();
+        for ( const Piece& piece : pieces ) {
+            Elf64_Off pieceEnd = piece.offset + piece.size;
+            if ( pieceEnd <= start || piece.offset >= end ) {
+                visible.push_back(piece);
+                continue;
+            }
+            if ( piece.offset < start ) {
+                Piece left = piece;
+                left.size = start - piece.offset;
+                visible.push_back(left);
+            }
+            if ( pieceEnd > end ) {
+                Piece right = piece;
+                right.offset = end;
+                right.size = pieceEnd - end;
+                right.skip += end - piece.offset;
+                visible.push_back(right);
+            }
+        }
+        Piece piece = { start, end - start, i, 0 };
+        visible.push_back(piece);
+
+        sort(visible.begin(), visible.end(),
+             [] (const Piece& lhs, const Piece& rhs) -> bool {
+                 return lhs.offset < rhs.offset;
+             });
+        pieces.swap(visible);
+    }
+}
+
+Elf64_Off ElfFile::WastedBytes() const {
+    Elf64_Off used = 0;
+    for ( const Piece& piece : pieces ) {
+        used += piece.size;
+    }
+    return fileSize - used;
+}
+
+const char* ElfFile::TableBytes(const Extent& extent) const {
+    switch ( extent.source ) {
+    case Extent::FILE_HEADER:
+        return reinterpret_cast<const char*>(&header);
+    case Extent::PROGRAM_HEADERS:
+        return reinterpret_cast<const char*>(progHeaderTable.data());
+    case Extent::SECTION_HEADERS:
+        return reinterpret_cast<const char*>(sectionHeaderTable.data());
+    default:
+        return NULL;
+    }
+}
+
+const char* ElfFile::SourceBytes(const Extent& extent) const {
+    if ( extent.source != Extent::SECTION_DATA ) {
+        return TableBytes(extent);
+    } else if ( sourceData && extent.section->IsView() ) {
+        return sourceData + extent.from;
+    } else {
+        return NULL;
+    }
+}
+
+void ElfFile::CopyPiece(const Piece& piece, char* dest) const {
+    const Extent& extent = extents[piece.extent];
+    const char* src = SourceBytes(extent);
+    if ( src ) {
+        BlockCopy(dest, src + piece.skip, piece.size);
+    } else {
+        extent.section->ReadRawData(piece.skip, dest, piece.size);
+    }
+}
+
+/*
+ * Copy every piece into the image at dest. The pieces are cut into
+ * chunks, which are dealt out largest first to whichever thread has the
+ * least to do so far.
+ */
+void ElfFile::CopyPieces( const vector<Piece>& todo,
+                          char* dest,
+                          size_t threads) const
+{
+    Elf64_Xword total = 0;
+    for ( const Piece& piece : todo ) {
+        total += piece.size;
+    }
+    if ( threads > total / MIN_BYTES_PER_THREAD ) {
+        threads = total / MIN_BYTES_PER_THREAD;
+    }
+
+    if ( threads <= 1 ) {
+        for ( const Piece& piece : todo ) {
+            CopyPiece(piece, dest + piece.offset);
+        }
+        return;
+    }
+
+    // Small enough that one huge section doesn't leave everyone else
+    // waiting
+    Elf64_Xword chunkSize = max(total / (threads * 4), MIN_BYTES_PER_THREAD);
+    vector<Piece> chunks;
+    for ( const Piece& piece : todo ) {
+        for ( Elf64_Xword done = 0; done < piece.size; done += chunkSize ) {
+            Piece chunk = piece;
+            chunk.offset += done;
+            chunk.skip += done;
+            chunk.size = min(piece.size - done, chunkSize);
+            chunks.push_back(chunk);
+        }
+    }
+    stable_sort(chunks.begin(), chunks.end(),
+        [] (const Piece& lhs, const Piece& rhs) -> bool {
+            return lhs.size > rhs.size;
+        });
+
+    vector<vector<Piece> > work(threads);
+    vector<Elf64_Xword> load(threads, 0);
+    for ( const Piece& chunk : chunks ) {
+        size_t t = min_element(load.begin(), load.end()) - load.begin();
+        work[t].push_back(chunk);
+        load[t] += chunk.size;
+    }
+
+    vector<std::exception_ptr> errors(threads);
+    vector<std::thread> workers;
+    workers.reserve(threads);
+    for ( size_t t = 0; t < threads; ++t ) {
+        workers.push_back(std::thread([this, t, dest, &work, &errors] () {
+            try {
+                for ( const Piece& chunk : work[t] ) {
+                    CopyPiece(chunk, dest + chunk.offset);
+                }
+            } catch ( ... ) {
+                errors[t] = std::current_exception();
+            }
+        }));
+    }
+    for ( size_t t = 0; t < threads; ++t ) {
+        workers[t].join();
+    }
+    for ( std::exception_ptr& error : errors ) {
+        if ( error ) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void ElfFile::WritePiece(const Piece& piece, BinaryWriter& w) const {
+    const Extent& extent = extents[piece.extent];
+    if ( extent.source == Extent::SECTION_DATA ) {
+        extent.section->WriteRawData(w, piece.skip, piece.size);
+    } else {
+        w.Write(TableBytes(extent) + piece.skip, piece.size);
+    }
+}
+
 void ElfFile::WriteToFile(BinaryWriter& w) {
-    this->file.Reader().Read(w,this->file.Size());
+    Elf64_Off pos = 0;
+    for ( const Piece& piece : pieces ) {
+        if ( piece.offset > pos ) {
+            w.File().Fill(w.Offset() + pos, '\0', piece.offset - pos);
+        }
+        BinaryWriter dest = w + piece.offset;
+        WritePiece(piece, dest);
+        pos = piece.offset + piece.size;
+    }
+    if ( fileSize > pos ) {
+        w.File().Fill(w.Offset() + pos, '\0', fileSize - pos);
+    }
+}
+
+void ElfFile::WriteToFile(const string& path, size_t threads) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if ( fd < 0 ) {
+        throw "ElfFile: Failed to create " + path;
+    }
+
+    // A fresh file of the right size reads back as zeros: only the pieces
+    // need writing
+    if ( ftruncate(fd, fileSize) != 0 ) {
+        close(fd);
+        throw "ElfFile: Failed to resize " + path;
+    }
+
+    vector<Piece> todo = CopyInKernel(fd);
+    if ( todo.empty() ) {
+        close(fd);
+        return;
+    }
+
+    void* out = mmap(NULL, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    try {
+        if ( out == MAP_FAILED ) {
+            WritePieces(todo, fd, path);
+        } else {
+            CopyPieces(todo, static_cast<char*>(out), threads);
+        }
+    } catch ( ... ) {
+        if ( out != MAP_FAILED ) {
+            munmap(out, fileSize);
+        }
+        close(fd);
+        throw;
+    }
+    if ( out != MAP_FAILED ) {
+        munmap(out, fileSize);
+    }
+    close(fd);
+}
+
+/*
+ * Copy size bytes from in to out without bringing them into user space.
+ *
+ * @returns The number of bytes copied: anything short of size is down to
+ *          the file systems involved not supporting it
+ */
+static Elf64_Xword CopyFileRange( int in,
+                                  off_t inOffset,
+                                  int out,
+                                  off_t outOffset,
+                                  Elf64_Xword size)
+{
+    Elf64_Xword done = 0;
+    while ( done < size ) {
+        ssize_t copied = copy_file_range(in, &inOffset, out, &outOffset,
+                                         size - done, 0);
+        if ( copied < 0 && errno == EINTR ) {
+            continue;
+        } else if ( copied <= 0 ) {
+            break;
+        }
+        done += copied;
+    }
+
+    // Older kernels can't copy_file_range between file systems, but
+    // sendfile will still save a trip through user space
+    if ( done < size && lseek(out, outOffset, SEEK_SET) == outOffset ) {
+        while ( done < size ) {
+            ssize_t copied = sendfile(out, in, &inOffset, size - done);
+            if ( copied < 0 && errno == EINTR ) {
+                continue;
+            } else if ( copied <= 0 ) {
+                break;
+            }
+            done += copied;
+        }
+    }
+    return done;
+}
+
+vector<ElfFile::Piece> ElfFile::CopyInKernel(int fd) const {
+    vector<Piece> todo;
+    todo.reserve(pieces.size());
+
+    // Once the kernel has turned us down, it isn't going to change its mind
+    bool kernel = sourceFd >= 0;
+    for ( const Piece& piece : pieces ) {
+        const Extent& extent = extents[piece.extent];
+        bool unchanged =    extent.source == Extent::SECTION_DATA
+                         && extent.section->IsView();
+        if ( !kernel || !unchanged ) {
+            todo.push_back(piece);
+            continue;
+        }
+
+        Elf64_Xword copied = CopyFileRange( sourceFd,
+                                            extent.from + piece.skip,
+                                            fd,
+                                            piece.offset,
+                                            piece.size);
+        if ( copied < piece.size ) {
+            Piece rest = piece;
+            rest.offset += copied;
+            rest.skip += copied;
+            rest.size -= copied;
+            todo.push_back(rest);
+            kernel = false;
+        }
+    }
+    return todo;
+}
+
+/*
+ * For files we can't map: pwrite each piece, via a small buffer
+ */
+void ElfFile::WritePieces( const vector<Piece>& todo,
+                           int fd,
+                           const string& path) const
+{
+    vector<char> buffer(64 * 1024);
+    for ( const Piece& piece : todo ) {
+        for ( Elf64_Xword done = 0; done < piece.size; ) {
+            Piece chunk = piece;
+            chunk.skip += done;
+            chunk.size = min<Elf64_Xword>(piece.size - done, buffer.size());
+            CopyPiece(chunk, buffer.data());
+
+            ssize_t written = pwrite(fd, buffer.data(), chunk.size,
+                                     piece.offset + done);
+            if ( written < 0 && errno == EINTR ) {
+                continue;
+            } else if ( written <= 0 ) {
+                throw "ElfFile: Failed to write " + path;
+            }
+            done += written;
+        }
+    }
 }
 
 void ElfFile::Bootstrap(ElfContent& content) {
@@ -273,63 +620,111 @@ void ElfFile::Bootstrap(ElfContent& content) {
     }
 }
 
-ElfFile::SectionOffsets::SectionOffsets(const ElfContent& content) {
+// The loader maps segments a page at a time
+static const Elf64_Xword LOAD_PAGE_SIZE = 0x1000;
+
+ElfFile::SectionOffsets::SectionOffsets()
+    : endOfMapped(0),
+      cursor(0)
+{
+}
+
+void ElfFile::SectionOffsets::Plan( const ElfContent& content,
+                                    Elf64_Off headerEnd)
+{
+    index = AddressIndex(content.sections, content.progHeaders);
     FindLoadables(content);
 
-    Elf64_Off fileOffset = 0;
+    vector<Region*> loaded;
+    for ( size_t i = 0; i < regions.size(); ++i ) {
+        if ( content.progHeaders[i]->IsLoadableSegment() ) {
+            loaded.push_back(&regions[i]);
+        }
+    }
+    stable_sort(loaded.begin(), loaded.end(),
+        [] (const Region* lhs, const Region* rhs) -> bool {
+            return lhs->startAddr < rhs->startAddr;
+        });
 
-    for ( auto it = loadedMap.begin(); it != loadedMap.end(); ++it )
+    cursor = headerEnd;
+    for ( Region* next : loaded )
     {
-        Region& region = it->second;
-        region.startOffset = fileOffset;
-        region.endOffset += region.startOffset;
+        Region& region = *next;
+        Elf64_Xword fileSize = region.endOffset;
+
+        // The segment's first lead bytes don't hold anything (or just the
+        // headers we've already written), so they may overlap whatever
+        // came before
+        Elf64_Off earliest = 0;
+        if ( !region.mapsHeaders && cursor > region.lead ) {
+            earliest = cursor - region.lead;
+        }
 
-        // TODO: do this alignment properly, and stop hacking in an extra 4 bytes
-        fileOffset = region.endOffset + 4;
+        // Smallest offset >= earliest with the same remainder as the
+        // segment's address
+        Elf64_Xword align = region.alignment;
+        region.startOffset =   earliest
+                             + (   region.startAddr % align
+                                 + align
+                                 - earliest % align ) % align;
+        region.endOffset = region.startOffset + fileSize;
+        cursor = max(cursor, region.endOffset);
     }
+    endOfMapped = cursor;
 }
 
-
 void ElfFile::SectionOffsets::FindLoadables(const ElfContent& content) {
-    for (const ProgramHeader* header : content.progHeaders)
+    regions.assign(content.progHeaders.size(), Region());
+    for ( size_t i = 0; i < content.progHeaders.size(); ++i )
     {
+        const ProgramHeader* header = content.progHeaders[i];
         if ( header->IsLoadableSegment() )
         {
-            loadedMap[header->Address()] = {
+            Region region = {
                 header->Address(),
                 header->AddrEnd(),
                 0,
-                header->FileSize()
+                header->FileSize(),
+                max(header->Alignment(), LOAD_PAGE_SIZE),
+                header->FileSize(),
+                // Only a segment from the top of the input holds the headers
+                header->DataStart() == 0
             };
+
+            long first = index.FirstSectionIn(
+                             region.startAddr,
+                             region.startAddr + header->FileSize());
+            if ( first != AddressIndex::NOT_FOUND ) {
+                region.lead =   content.sections[first]->Address()
+                              - region.startAddr;
+            }
+            regions[i] = region;
         }
     }
 }
 
-Elf64_Off ElfFile::SectionOffsets::AddressToOffset(Elf64_Addr& addr) {
-    Elf64_Off offset = 0;
-
-    for ( auto it = loadedMap.begin();
-          it != loadedMap.end() && offset == 0;
-          ++it )
-    {
-        Region& region = it->second;
-        if ( region.startAddr <= addr && region.endAddr >= addr)
-        {
-            Elf64_Off regionOffset = addr - region.startAddr;
-            offset = regionOffset + region.startOffset;
-        }
+Elf64_Off ElfFile::SectionOffsets::AddressToOffset(const Elf64_Addr& addr) {
+    long segment = index.SegmentAt(addr);
+    if ( segment == AddressIndex::NOT_FOUND ) {
+        return 0;
     }
-    return offset;
+    const Region& region = regions[segment];
+    return addr - region.startAddr + region.startOffset;
+}
+
+bool ElfFile::SectionOffsets::IsMapped(const Elf64_Addr& addr) const {
+    return index.SegmentAt(addr) != AddressIndex::NOT_FOUND;
+}
+
+Elf64_Off ElfFile::SectionOffsets::Append( Elf64_Xword size,
+                                           Elf64_Xword alignment)
+{
+    cursor = AlignTo(cursor, alignment);
+    Elf64_Off start = cursor;
+    cursor += size;
+    return start;
 }
 
 Elf64_Off ElfFile::SectionOffsets::EndOfMapped() {
-    if ( loadedMap.size() > 0)
-    {
-        Region& lastRegion = loadedMap.rbegin()->second;
-        return lastRegion.endOffset;
-    }
-    else
-    {
-        return 0;
-    }
+    return endOfMapped;
 }
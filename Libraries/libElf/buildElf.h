@@ -12,20 +12,22 @@
 #include "programHeader.h"
 #include "section.h"
 #include "symbol.h"
+#include "nameIndex.h"
+#include "addressIndex.h"
 
 struct ElfContent {
-    Section* GetSection(string name) {
-        auto loc = sectionMap.find(name);
-        if ( loc != sectionMap.end() ) {
-            return sections[loc->second];
+    Section* GetSection(const string& name) {
+        int idx = sectionMap.Find(name);
+        if ( idx != NameIndex::NOT_FOUND ) {
+            return sections[idx];
         } else {
             return NULL;
         }
     }
-    Symbol* GetSymbol(string name) {
-        auto loc = symbolMap.find(name);
-        if ( loc != symbolMap.end() ) {
-            return symbols[loc->second];
+    Symbol* GetSymbol(const string& name) {
+        int idx = symbolMap.Find(name);
+        if ( idx != NameIndex::NOT_FOUND ) {
+            return symbols[idx];
         } else {
             return NULL;
         }
@@ -34,27 +36,72 @@ struct ElfContent {
     std::vector<Section *>& sections;
     std::vector<ProgramHeader *>& progHeaders;
     std::vector<Symbol *>& symbols;
-    std::map<string, int>& sectionMap;
-    std::map<string, int>& symbolMap;
+    NameIndex& sectionMap;
+    NameIndex& symbolMap;
+
+    // The file the content was parsed from, if known. Sections which are
+    // still views (see Section::IsView) hold exactly its bytes.
+    const FileLikeReader* source;
 };
 
+/**
+    \class   ElfFile
+    \brief   Lays out a new elf file from ElfContent, and writes it out
+    \details The constructor only works out where everything goes: the
+             offsets of the program headers, each section's data and the
+             section table. The headers themselves are small, and are built
+             up front; section data isn't touched until WriteToFile, which
+             copies it straight from each Section into the output.
+
+             Sections may be placed on top of each other (or the headers):
+             as with writing each one in turn, the last one placed wins.
+*/
 class ElfFile{
 public:
     ElfFile(ElfContent &data);
     ElfFile(ElfContent &&data): ElfFile(data){}
-    void MakeNewHeader(ElfContent &data);
     void ProcessProgHeaders(ElfContent& data);
     void WriteSectionHeaders(ElfContent& data);
+
+    /*
+     * Write the file, starting at w. Every byte is written in order, so
+     * w need not support seeking.
+     */
     void WriteToFile(BinaryWriter& w);
     inline void WriteToFile(BinaryWriter&& w) { WriteToFile(w); }
+
+    /*
+     * Create (or replace) the file at path. It is sized up front, and
+     * each section is copied directly into a mapping of it.
+     *
+     * Sections that haven't been changed since they were read from a
+     * mapped file are instead copied by the kernel (copy_file_range, or
+     * failing that sendfile), which may share the blocks rather than
+     * copying them.
+     *
+     * The copies are shared between up to threads threads: they write
+     * to separate parts of the file, so the result is the same however
+     * many there are.
+     */
+    void WriteToFile(const string& path, size_t threads = 1);
+
+    // Size, in bytes, of the file we'll write
+    Elf64_Off Size() const { return fileSize; }
+
+    /*
+     * Bytes of the file that belong to neither a header nor a section:
+     * alignment padding, whether ours or left between sections by
+     * whatever built the input.
+     */
+    Elf64_Off WastedBytes() const;
 protected:
     void InitialiseFile(ElfContent& data);
     void InitialiseHeader(ElfContent& data);
     bool IsSpecialSection(Section& s);
-    void WriteSpecial(ElfContent&, string name, long&, BinaryWriter&);
+    void WriteSpecial(ElfContent&, string name, long&);
 
     /**
-     * Write the program headers
+     * Build the program header table
      *
      * @param data        The raw-data supplied to the c'tor
      * @param headers     A list of program headers, in the order in whih they
@@ -71,13 +118,41 @@ protected:
      */
     void Bootstrap(ElfContent& content);
 
-    BinaryWriter WriteDataSections( ElfContent& data);
+    /**
+     * Decide where each section's data goes: sections in a loadable
+     * segment go where their address says, everything else is appended.
+     */
+    void PlaceDataSections( ElfContent& data);
 private:
+    /*
+     * The layout planner: decides where in the file each loadable segment
+     * goes, and hands out space for everything else after them.
+     */
     class SectionOffsets {
     public:
-    	SectionOffsets(const ElfContent& content);
+    	SectionOffsets();
+
+        /*
+         * Place the loadable segments, in address order, as early as
+         * possible after headerEnd (where the program header table
+         * finishes) whilst keeping p_vaddr % p_align == p_offset % p_align.
+         * A segment that mapped the file headers in the input keeps doing
+         * so.
+         */
+        void Plan(const ElfContent& content, Elf64_Off headerEnd);
+
+    	Elf64_Off AddressToOffset(const Elf64_Addr& addr);
+
+        // True if addr is within one of the loadable segments
+        bool IsMapped(const Elf64_Addr& addr) const;
 
-    	Elf64_Off AddressToOffset(Elf64_Addr& addr);
+        /*
+         * Reserve size bytes after everything placed so far, aligned to
+         * alignment.
+         *
+         * @returns The offset of the new space
+         */
+        Elf64_Off Append(Elf64_Xword size, Elf64_Xword alignment);
 
     	Elf64_Off EndOfMapped();
     private:
@@ -89,21 +164,93 @@ private:
     		Elf64_Addr  endAddr;
     		Elf64_Off   startOffset;
     		Elf64_Off   endOffset;
+            Elf64_Xword alignment;
+            // Bytes from the start of the segment to the first section in
+            // it with any file data
+            Elf64_Xword lead;
+            bool        mapsHeaders;
     	};
 
-    	std::map<Elf64_Addr,Region>    loadedMap;
+        // By segment: only the loadable ones are filled in
+        std::vector<Region> regions;
+        AddressIndex index;
+
+        Elf64_Off endOfMapped;
+        Elf64_Off cursor;
 
     } offsets;
 
+    /*
+     * Something to be written to the output: one of our tables, or a
+     * section's data
+     */
+    struct Extent {
+        enum Source {
+            FILE_HEADER,
+            PROGRAM_HEADERS,
+            SECTION_HEADERS,
+            SECTION_DATA
+        };
+        Source          source;
+        Elf64_Off       offset;
+        Elf64_Xword     size;
+        const Section*  section;
+        // Where the section's data was in the input
+        Elf64_Off       from;
+    };
+
+    /*
+     * The part of an extent that isn't hidden by a later one
+     */
+    struct Piece {
+        Elf64_Off    offset;
+        Elf64_Xword  size;
+        size_t       extent;
+        // Bytes into the extent that the piece starts
+        Elf64_Xword  skip;
+    };
+
+    void AddExtent(Extent::Source source,
+                   Elf64_Off offset,
+                   Elf64_Xword size,
+                   const Section* section = NULL);
+    void PlaceSection(Section& sec, Elf64_Off offset);
+    void PlanPieces();
+    const char* TableBytes(const Extent& extent) const;
+    // The bytes to be written for extent, if they're in memory
+    const char* SourceBytes(const Extent& extent) const;
+    void CopyPiece(const Piece& piece, char* dest) const;
+    void CopyPieces( const vector<Piece>& todo,
+                     char* dest,
+                     size_t threads) const;
+    void WritePiece(const Piece& piece, BinaryWriter& w) const;
+    void WritePieces( const vector<Piece>& todo,
+                      int fd,
+                      const string& path) const;
+
+    /*
+     * Have the kernel copy every piece it can from the input to fd.
+     *
+     * @returns The pieces (or parts of them) still to be copied
+     */
+    vector<Piece> CopyInKernel(int fd) const;
+
     ElfHeaderX86_64 header;
+    // The input, if it's a mapped file
+    const char* sourceData;
+    int sourceFd;
+    vector<Elf64_Phdr> progHeaderTable;
+    vector<Elf64_Shdr> sectionHeaderTable;
 
-    //final data
-    DataVector file;
+    // Everything to be written, in the order it was placed
+    vector<Extent> extents;
+    // What's actually visible, in file order
+    vector<Piece> pieces;
 
     // utility data
-    long sectionDataLength;
-    BinaryWriter dataSectionStart;
-    BinaryWriter sectionHeadersStart;
+    Elf64_Off dataSectionStart;
+    Elf64_Off sectionHeadersStart;
+    Elf64_Off fileSize;
 };
 
 
@@ -206,7 +353,11 @@ private:
  * +-------------+
  * -> Loadable segments must be aligned to p_align value in the 
  *    header file section: p_vaddr % p_align = p_offset % p_align. 
- *    This will be handled here
+ *    This will be handled here (by SectionOffsets), using no more
+ *    padding than the congruence needs. Segments with a p_align smaller
+ *    than a page are aligned to a page, as the loader maps whole pages.
+ * -> Sections without an address (and the section table) are appended
+ *    after the last segment, each aligned to its sh_addralign.
  * -> Now it is required that: sh_addr % sh_addralign = 0. However 
  *    the caller must handle this, as changing anything here would 
  *    require re-locating symbols
@@ -0,0 +1,227 @@
+#include "byteScan.h"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define BYTE_SCAN_X86
+    #include <immintrin.h>
+#endif
+
+using namespace std;
+
+/*
+ * Scalar kernels: also used to finish off the tail of a block which is
+ * too short for a full vector
+ */
+static const char* FindScalar(const char* begin, const char* end, unsigned char c) {
+    for ( const char* p = begin; p < end; ++p ) {
+        if ( (unsigned char)*p == c ) return p;
+    }
+    return end;
+}
+
+static const char* FindLastScalar(const char* begin, const char* end, unsigned char c) {
+    for ( const char* p = end; p > begin; --p ) {
+        if ( (unsigned char)*(p-1) == c ) return p-1;
+    }
+    return NULL;
+}
+
+static size_t FindAllScalar(const char* begin, 
+                            const char* end, 
+                            unsigned char c, 
+                            vector<long>& found) 
+{
+    size_t count = 0;
+    for ( const char* p = begin; p < end; ++p ) {
+        if ( (unsigned char)*p == c ) {
+            found.push_back(p - begin);
+            ++count;
+        }
+    }
+    return count;
+}
+
+#ifdef BYTE_SCAN_X86
+
+/*
+ * SSE2: 16 bytes at a time. Always available on x86_64.
+ *
+ * Each block is compared against c, and the results packed into a bit 
+ * mask: bit i is set if byte i matched.
+ */
+__attribute__((target("sse2")))
+static const char* FindSSE2(const char* begin, const char* end, unsigned char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p = begin;
+    for ( ; end - p >= 16; p += 16 ) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if ( mask ) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindScalar(p, end, c);
+}
+
+__attribute__((target("sse2")))
+static const char* FindLastSSE2(const char* begin, const char* end, unsigned char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p = end;
+    for ( ; p - begin >= 16; p -= 16 ) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p - 16));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if ( mask ) {
+            return p - 16 + (31 - __builtin_clz(mask));
+        }
+    }
+    return FindLastScalar(begin, p, c);
+}
+
+__attribute__((target("sse2")))
+static size_t FindAllSSE2(const char* begin, 
+                          const char* end, 
+                          unsigned char c, 
+                          vector<long>& found) 
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t count = 0;
+    const char* p = begin;
+    for ( ; end - p >= 16; p += 16 ) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        while ( mask ) {
+            found.push_back(p - begin + __builtin_ctz(mask));
+            mask &= mask - 1;
+            ++count;
+        }
+    }
+    size_t tail = found.size();
+    count += FindAllScalar(p, end, c, found);
+    for ( size_t i = tail; i < found.size(); ++i ) {
+        found[i] += p - begin;
+    }
+    return count;
+}
+
+/*
+ * AVX2: 32 bytes at a time
+ */
+__attribute__((target("avx2")))
+static const char* FindAVX2(const char* begin, const char* end, unsigned char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p = begin;
+    for ( ; end - p >= 32; p += 32 ) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if ( mask ) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return FindSSE2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+static const char* FindLastAVX2(const char* begin, const char* end, unsigned char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p = end;
+    for ( ; p - begin >= 32; p -= 32 ) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p - 32));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if ( mask ) {
+            return p - 32 + (31 - __builtin_clz(mask));
+        }
+    }
+    return FindLastSSE2(begin, p, c);
+}
+
+__attribute__((target("avx2")))
+static size_t FindAllAVX2(const char* begin, 
+                          const char* end, 
+                          unsigned char c, 
+                          vector<long>& found) 
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    size_t count = 0;
+    const char* p = begin;
+    for ( ; end - p >= 32; p += 32 ) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        while ( mask ) {
+            found.push_back(p - begin + __builtin_ctz(mask));
+            mask &= mask - 1;
+            ++count;
+        }
+    }
+    size_t tail = found.size();
+    count += FindAllSSE2(p, end, c, found);
+    for ( size_t i = tail; i < found.size(); ++i ) {
+        found[i] += p - begin;
+    }
+    return count;
+}
+
+#endif
+
+bool ByteScan::Supported(Kernel kernel) {
+    bool supported = false;
+#ifdef BYTE_SCAN_X86
+    // May be called before the CPU model has been initialised
+    __builtin_cpu_init();
+#endif
+    switch ( kernel ) {
+        case SCALAR:
+            supported = true;
+            break;
+#ifdef BYTE_SCAN_X86
+        case SSE2:
+            supported = __builtin_cpu_supports("sse2");
+            break;
+        case AVX2:
+            supported = __builtin_cpu_supports("avx2");
+            break;
+#endif
+        default:
+            supported = false;
+    }
+    return supported;
+}
+
+const ByteScan& ByteScan::Best() {
+    // Initialised (thread safely) on first use
+    static const ByteScan best( Supported(AVX2) ? AVX2 : 
+                                Supported(SSE2) ? SSE2 : 
+                                SCALAR );
+    return best;
+}
+
+ByteScan::ByteScan(Kernel k) 
+    : kernel(k),
+      find(FindScalar),
+      findLast(FindLastScalar),
+      findAll(FindAllScalar)
+{
+    if ( !Supported(kernel) ) {
+        throw "ByteScan: Kernel is not supported on this CPU";
+    }
+#ifdef BYTE_SCAN_X86
+    if ( kernel == SSE2 ) {
+        find = FindSSE2;
+        findLast = FindLastSSE2;
+        findAll = FindAllSSE2;
+    } else if ( kernel == AVX2 ) {
+        find = FindAVX2;
+        findLast = FindLastAVX2;
+        findAll = FindAllAVX2;
+    }
+#endif
+}
+
+const char* ByteScan::Name() const {
+    const char* name = "scalar";
+    if ( kernel == SSE2 ) {
+        name = "sse2";
+    } else if ( kernel == AVX2 ) {
+        name = "avx2";
+    }
+    return name;
+}
@@ -0,0 +1,76 @@
+#ifndef BYTE_SCAN_H
+#define BYTE_SCAN_H
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+/**
+    \class   ByteScan
+    \brief   Search a block of memory for a byte value
+    \details Vectorised (SSE2 / AVX2) searches, used to find the end of 
+             strings and the like in mapped files. 
+
+             Each instruction set has its own ByteScan object; Best() picks
+             the widest one the CPU supports the first time it is called.
+             Every kernel gives the same answers, so callers should just 
+             use Best().
+*/
+class ByteScan {
+public:
+    enum Kernel {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    // The fastest kernel available on this machine
+    static const ByteScan& Best();
+
+    // Can this machine run kernel?
+    static bool Supported(Kernel kernel);
+
+    /*
+     * Use a specific kernel, which must be supported
+     */
+    ByteScan(Kernel kernel);
+
+    /*
+     * First c in [begin, end), or end if there isn't one
+     */
+    const char* Find(const char* begin, const char* end, unsigned char c) const {
+        return begin < end ? find(begin,end,c) : end;
+    }
+
+    /*
+     * Last c in [begin, end), or NULL if there isn't one
+     */
+    const char* FindLast(const char* begin, const char* end, unsigned char c) const {
+        return begin < end ? findLast(begin,end,c) : NULL;
+    }
+
+    /*
+     * Append the offset (from begin) of every c in [begin, end) to found.
+     * Returns the number of matches.
+     */
+    size_t FindAll(const char* begin, 
+                   const char* end,
+                   unsigned char c,
+                   vector<long>& found) const 
+    {
+        return begin < end ? findAll(begin,end,c,found) : 0;
+    }
+
+    Kernel Type() const { return kernel; }
+    const char* Name() const;
+
+private:
+    typedef const char* (*FindFn)(const char*, const char*, unsigned char);
+    typedef size_t (*FindAllFn)(const char*, const char*, unsigned char, vector<long>&);
+
+    Kernel kernel;
+    FindFn find;
+    FindFn findLast;
+    FindAllFn findAll;
+};
+#endif
@@ -0,0 +1,66 @@
+#include "elfArena.h"
+#include <cstdint>
+
+using namespace std;
+
+const size_t ElfArena::DEFAULT_BLOCK_SIZE;
+
+ElfArena::ElfArena(size_t size)
+    : blockSize(size), reserved(0), next(NULL), end(NULL)
+{
+}
+
+ElfArena::~ElfArena() {
+    Release();
+    for ( Block& block: blocks ) {
+        delete [] block.start;
+    }
+}
+
+void* ElfArena::Allocate(size_t size, size_t align) {
+    uintptr_t pos = reinterpret_cast<uintptr_t>(next);
+    uintptr_t aligned = (pos + align - 1) & ~(uintptr_t)(align - 1);
+
+    if ( next == NULL || aligned + size > reinterpret_cast<uintptr_t>(end) ) {
+        // Over-sized requests get a block to themselves
+        size_t newSize = size + align > blockSize ? size + align : blockSize;
+        Block block = { new char[newSize], newSize };
+        blocks.push_back(block);
+        reserved += newSize;
+
+        next = block.start;
+        end = block.start + block.size;
+
+        pos = reinterpret_cast<uintptr_t>(next);
+        aligned = (pos + align - 1) & ~(uintptr_t)(align - 1);
+    }
+
+    next = reinterpret_cast<char*>(aligned + size);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void ElfArena::Release() {
+    for ( size_t i = cleanups.size(); i > 0; --i ) {
+        Cleanup& c = cleanups[i-1];
+        c.cleanup(c.objects, c.count);
+    }
+    cleanups.clear();
+
+    // Hang on to the first block for re-use, unless it was an over-sized
+    // one-off
+    size_t keep = ( blocks.size() > 0 && blocks[0].size == blockSize ) ? 1 : 0;
+    for ( size_t i = keep; i < blocks.size(); ++i ) {
+        delete [] blocks[i].start;
+    }
+    blocks.resize(keep);
+
+    if ( keep ) {
+        reserved = blocks[0].size;
+        next = blocks[0].start;
+        end = blocks[0].start + blocks[0].size;
+    } else {
+        reserved = 0;
+        next = NULL;
+        end = NULL;
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef ELF_ARENA_H
+#define ELF_ARENA_H
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+    \class   ElfArena
+    \brief   Block allocator for the objects built by ElfParser
+    \details Objects are carved out of large blocks, in the order they are
+             created, so a parsed file's sections (or symbols...) sit next
+             to each other in memory rather than being scattered across 
+             the heap.
+
+             Nothing is freed individually: Release() (or the destructor)
+             runs every registered destructor, in reverse order of 
+             creation, and then hands back the blocks in one go. The first
+             block is kept, so an arena re-used for a batch of files 
+             doesn't go back to the heap for each one.
+
+             The arena is not thread safe. Callers that construct objects
+             on several threads should Allocate the storage up front, and 
+             Manage it once construction is complete.
+*/
+class ElfArena {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    ElfArena (size_t blockSize = DEFAULT_BLOCK_SIZE);
+    virtual ~ElfArena ();
+
+    /*
+     * Construct a new T in the arena
+     */
+    template <class T, class... Args>
+    T* New(Args&&... args) {
+        void* storage = Allocate(sizeof(T), alignof(T));
+        T* object = new (storage) T(std::forward<Args>(args)...);
+        Manage(object, 1);
+        return object;
+    }
+
+    /*
+     * Raw, uninitialised, storage for count T objects
+     */
+    template <class T>
+    T* Allocate(size_t count) {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /*
+     * Have the arena destroy count T objects, which the caller has
+     * constructed in place at objects
+     */
+    template <class T>
+    void Manage(T* objects, size_t count) {
+        if ( !std::is_trivially_destructible<T>::value && count > 0 ) {
+            Cleanup cleanup = { &ElfArena::Destroy<T>, objects, count };
+            cleanups.push_back(cleanup);
+        }
+    }
+
+    /*
+     * Take ownership of an object which was allocated with new
+     */
+    template <class T>
+    T* Adopt(T* object) {
+        Cleanup cleanup = { &ElfArena::Delete<T>, object, 1 };
+        cleanups.push_back(cleanup);
+        return object;
+    }
+
+    /*
+     * Destroy every object in the arena
+     */
+    void Release();
+
+    // Total size of the blocks currently held
+    size_t BytesReserved() const { return reserved; }
+
+private:
+    ElfArena (const ElfArena& rhs);
+    ElfArena& operator=(const ElfArena& rhs);
+
+    void* Allocate(size_t size, size_t align);
+
+    template <class T>
+    static void Destroy(void* objects, size_t count) {
+        T* typed = static_cast<T*>(objects);
+        for ( size_t i=count; i > 0; --i ) {
+            typed[i-1].~T();
+        }
+    }
+
+    template <class T>
+    static void Delete(void* object, size_t) {
+        delete static_cast<T*>(object);
+    }
+
+    struct Cleanup {
+        void (*cleanup)(void*, size_t);
+        void* objects;
+        size_t count;
+    };
+
+    struct Block {
+        char* start;
+        size_t size;
+    };
+
+    size_t blockSize;
+    size_t reserved;
+    std::vector<Block> blocks;
+    std::vector<Cleanup> cleanups;
+    char* next;
+    char* end;
+};
+#endif
@@ -0,0 +1,297 @@
+#include "elfBatch.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <dirent.h>
+#include <elf.h>
+#include <sys/stat.h>
+
+// Files started per thread before we insist on writing some out
+static const size_t DEFAULT_IN_FLIGHT_PER_THREAD = 4;
+
+ElfBatchOptions::ElfBatchOptions()
+    : threads(std::thread::hardware_concurrency()),
+      maxInFlight(0),
+      source("")
+{
+    if ( threads < 1 ) {
+        threads = 1;
+    }
+}
+
+ElfBatch::ElfBatch(size_t nthreads, size_t inFlight)
+    : threads(nthreads < 1 ? 1 : nthreads),
+      maxInFlight(inFlight)
+{
+    if ( maxInFlight == 0 ) {
+        maxInFlight = threads * DEFAULT_IN_FLIGHT_PER_THREAD;
+    }
+    // Every thread needs a file to work on
+    if ( maxInFlight < threads ) {
+        maxInFlight = threads;
+    }
+}
+
+bool ElfBatch::RunJob( const Job& job,
+                       const string& input,
+                       ostream& out,
+                       ostream& err)
+{
+    bool ok = false;
+    try {
+        job(input, out);
+        ok = true;
+    } catch ( const string& error ) {
+        err << input << ": " << error << endl;
+    } catch ( const char* error ) {
+        err << input << ": " << error << endl;
+    } catch ( const exception& error ) {
+        err << input << ": " << error.what() << endl;
+    }
+    return ok;
+}
+
+size_t ElfBatch::Run( const vector<string>& inputs,
+                      const Job& job,
+                      ostream& out,
+                      ostream& err)
+{
+    size_t failed = 0;
+    if ( inputs.size() == 0 ) {
+        return failed;
+    }
+
+    // If there's only one thread, just run everything here
+    if ( threads == 1 ) {
+        for ( const string& input: inputs ) {
+            if ( !RunJob(job, input, out, err) ) {
+                ++failed;
+            }
+        }
+        return failed;
+    }
+
+    struct Result {
+        Result(): done(false), ok(false) {}
+        bool done;
+        bool ok;
+        string out;
+        string err;
+    };
+    vector<Result> results(inputs.size());
+
+    mutex lock;
+    condition_variable progress;
+    size_t next = 0;     // The next file to start
+    size_t written = 0;  // Everything before this has been written
+
+    auto worker = [&] () {
+        unique_lock<mutex> guard(lock);
+        for ( ; ; ) {
+            progress.wait(guard, [&] () {
+                return next >= inputs.size() ||
+                       next < written + maxInFlight;
+            });
+            if ( next >= inputs.size() ) {
+                break;
+            }
+            size_t i = next++;
+
+            guard.unlock();
+            ostringstream jobOut;
+            ostringstream jobErr;
+            bool ok = RunJob(job, inputs[i], jobOut, jobErr);
+            guard.lock();
+
+            Result& result = results[i];
+            result.done = true;
+            result.ok = ok;
+            result.out = jobOut.str();
+            result.err = jobErr.str();
+
+            // Write out everything that is now next in line
+            while ( written < results.size() && results[written].done ) {
+                Result& head = results[written];
+                out << head.out;
+                err << head.err;
+                if ( !head.ok ) {
+                    ++failed;
+                }
+                string().swap(head.out);
+                string().swap(head.err);
+                ++written;
+            }
+            progress.notify_all();
+        }
+    };
+
+    size_t nthreads = min(threads, inputs.size());
+    vector<thread> workers;
+    workers.reserve(nthreads);
+    for ( size_t t = 0; t < nthreads; ++t ) {
+        workers.push_back(thread(worker));
+    }
+    for ( thread& t: workers ) {
+        t.join();
+    }
+    return failed;
+}
+
+/*
+ * True if path starts with the ELF magic number
+ */
+static bool IsElf(const string& path) {
+    char magic[SELFMAG];
+    ifstream file(path.c_str(), ios::binary);
+    return    file.read(magic, SELFMAG)
+           && memcmp(magic, ELFMAG, SELFMAG) == 0;
+}
+
+/*
+ * Add the ELF files under dir (in no particular order) to files. Links to
+ * directories are not followed, so we can't loop.
+ *
+ * Only the top directory has to be readable: a sub-directory we can't
+ * open is skipped, just like an entry we can't lstat.
+ */
+static void ListDirectory( const string& dir,
+                           vector<string>& files,
+                           bool required = true)
+{
+    unique_ptr<DIR, int (*)(DIR*)> handle(opendir(dir.c_str()), closedir);
+    if ( !handle ) {
+        if ( required ) {
+            throw "ElfBatch: Failed to open directory " + dir;
+        }
+        return;
+    }
+
+    struct dirent* entry = NULL;
+    while ( (entry = readdir(handle.get())) != NULL ) {
+        string name = entry->d_name;
+        if ( name == "." || name == ".." ) {
+            continue;
+        }
+        string path = dir + "/" + name;
+
+        struct stat info;
+        if ( lstat(path.c_str(), &info) != 0 ) {
+            continue;
+        }
+        if ( S_ISDIR(info.st_mode) ) {
+            ListDirectory(path, files, false);
+            continue;
+        }
+
+        bool regular =    S_ISREG(info.st_mode)
+                       || (    S_ISLNK(info.st_mode)
+                            && stat(path.c_str(), &info) == 0
+                            && S_ISREG(info.st_mode) );
+        // Sources, logs etc. aren't failures: they just aren't ours
+        if ( regular && IsElf(path) ) {
+            files.push_back(path);
+        }
+    }
+}
+
+/*
+ * Drop the files that are the outputs of another file in files
+ */
+static void DropOutputs(vector<string>& files, const string& suffix) {
+    set<string> names(files.begin(), files.end());
+    vector<string> inputs;
+    inputs.reserve(files.size());
+    for ( const string& file: files ) {
+        size_t stem = file.size() - suffix.size();
+        bool output =    file.size() > suffix.size()
+                      && file.compare(stem, string::npos, suffix) == 0
+                      && names.count(file.substr(0, stem)) > 0;
+        if ( !output ) {
+            inputs.push_back(file);
+        }
+    }
+    files.swap(inputs);
+}
+
+static void ReadList(istream& list, vector<string>& files) {
+    string line;
+    while ( getline(list, line) ) {
+        size_t end = line.find_last_not_of(" \t\r");
+        if ( end != string::npos ) {
+            files.push_back(line.substr(0, end + 1));
+        }
+    }
+}
+
+vector<string> ElfBatch::Inputs( const string& source,
+                                 const string& outputSuffix)
+{
+    vector<string> files;
+    struct stat info;
+    if ( source == "-" ) {
+        ReadList(cin, files);
+    } else if ( stat(source.c_str(), &info) != 0 ) {
+        throw "ElfBatch: No such file or directory: " + source;
+    } else if ( S_ISDIR(info.st_mode) ) {
+        ListDirectory(source, files);
+        if ( outputSuffix != "" ) {
+            DropOutputs(files, outputSuffix);
+        }
+        // readdir order depends on the file system: make it repeatable
+        sort(files.begin(), files.end());
+    } else {
+        ifstream list(source.c_str());
+        if ( !list ) {
+            throw "ElfBatch: Failed to open file list " + source;
+        }
+        ReadList(list, files);
+    }
+    return files;
+}
+
+/*
+ * Read a positive number for option opt
+ */
+static size_t Count(const char* opt, const char* value) {
+    char* end = NULL;
+    long count = value ? strtol(value, &end, 10) : 0;
+    if ( !value || *end != '\0' || count < 1 ) {
+        throw string("ElfBatch: ") + opt + " needs a number greater than 0";
+    }
+    return count;
+}
+
+int ElfBatch::ParseOptions( int argc,
+                            const char* argv[],
+                            ElfBatchOptions& options)
+{
+    int i = 1;
+    for ( ; i < argc; ++i ) {
+        string opt = argv[i];
+        const char* value = i + 1 < argc ? argv[i+1] : NULL;
+        if ( opt == "-j" ) {
+            options.threads = Count("-j", value);
+        } else if ( opt == "-m" ) {
+            options.maxInFlight = Count("-m", value);
+        } else if ( opt == "-b" ) {
+            if ( !value ) {
+                throw string("ElfBatch: -b needs a directory or file list");
+            }
+            options.source = value;
+        } else {
+            break;
+        }
+        // Skip the option's value
+        ++i;
+    }
+    return i;
+}
@@ -0,0 +1,92 @@
+#ifndef ELF_BATCH_H
+#define ELF_BATCH_H
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Command line options shared by the tools' batch modes:
+ *
+ *   -j <threads>        Files to process at once (default: one per core)
+ *   -m <max in flight>  Most files started but not yet written out
+ *                       (default: 4 per thread)
+ *   -b <source>         Process every ELF file in a directory, or every
+ *                       path (one per line) in a list file. "-" reads the
+ *                       list from stdin.
+ */
+struct ElfBatchOptions {
+    ElfBatchOptions();
+
+    size_t threads;
+    size_t maxInFlight;
+    string source;
+
+    bool Batch() const { return source != ""; }
+};
+
+/**
+    \class   ElfBatch
+    \brief   Run the same job over a list of files on a thread pool
+    \details Each job writes its results to an ostream. The results are
+             written out in input order, so a batch produces exactly what
+             running the files one at a time would.
+
+             Since results are held until everything before them has been
+             written, the number of files in flight (started but not yet
+             written) is capped: this bounds the memory used when one file
+             is much slower than the rest.
+
+             A job that throws (a string, or a std::exception) fails just
+             that file: the error is reported against the file and the
+             batch carries on.
+*/
+class ElfBatch {
+public:
+    typedef function<void (const string& input, ostream& out)> Job;
+
+    ElfBatch(size_t threads, size_t maxInFlight = 0);
+    ElfBatch(const ElfBatchOptions& options)
+        : ElfBatch(options.threads, options.maxInFlight) {}
+
+    /*
+     * Run job over inputs, writing the results to out and any errors to
+     * err. Returns the number of files that failed.
+     */
+    size_t Run( const vector<string>& inputs,
+                const Job& job,
+                ostream& out,
+                ostream& err);
+
+    /*
+     * The files named by source: the (sorted) ELF files under a
+     * directory, or the non-blank lines of a list file.
+     *
+     * A tool that writes <input><outputSuffix> next to each input should
+     * pass its suffix: files in the directory that are the output of an
+     * earlier run (the name of another file there, plus the suffix) are
+     * then left out.
+     */
+    static vector<string> Inputs( const string& source,
+                                  const string& outputSuffix = "");
+
+    /*
+     * Strip batch options from the front of argv, returning the index of
+     * the first argument left. Throws a string if an option is bad.
+     */
+    static int ParseOptions( int argc,
+                             const char* argv[],
+                             ElfBatchOptions& options);
+
+private:
+    static bool RunJob( const Job& job,
+                        const string& input,
+                        ostream& out,
+                        ostream& err);
+
+    size_t threads;
+    size_t maxInFlight;
+};
+#endif
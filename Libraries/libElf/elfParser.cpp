@@ -4,29 +4,120 @@ using namespace std;
 #include <sstream>
 
 #include "elfParser.h"
+#include "addressIndex.h"
 #include <memory>
+#include <thread>
+#include <exception>
+#include <algorithm>
 #include "logger.h"
 
-ElfParser::ElfParser(const FileLikeReader &f): 
-   reader(f), stringTable(reader), headerStrings(reader)
+/*
+ * Below this many symbols per thread, it isn't worth the cost of
+ * starting a new thread
+ */
+static const size_t MIN_SYMBOLS_PER_THREAD = 4096;
+
+ElfParser::ElfParser(const FileLikeReader &f,
+                     const ElfParserOptions& options):
+   ownArena(options.arena ? NULL : new ElfArena),
+   arena(options.arena ? options.arena : ownArena.get()),
+   reader(f), stringTable(reader), headerStrings(reader),
+   input(&f),
+   mappedFile(dynamic_cast<const ElfFileReader*>(&f)),
+   stream(dynamic_cast<const StreamReader*>(&f)),
+   sh_strtab(options.mergeStringTables ? StringTable::TAIL_MERGE 
+                                       : StringTable::APPEND)
 
 {
     linkSections=0;
+    linkSymbols=0;
+    symbolThreads = options.symbolThreads;
+    symbolStore = NULL;
+    symbolColumns = NULL;
+    symbolsRead = false;
+    progHeadersRead = false;
+    relocationsRead = false;
+    tablesWritten = false;
+    mergeStringTables = options.mergeStringTables;
     // if we try to index with these before they are set we want an
     // error to happen
     symidx=-1;
     stridx=-1;
 
-    header = new ElfHeaderX86_64(reader.Begin());
+    header = arena->New<ElfHeaderX86_64>(reader.Begin());
+
+    if ( stream ) {
+        // The program headers can only be decoded once we have the 
+        // sections, but normally come well before the section table
+        stream->Retain(header->ProgramHeadersStart(), 
+                       header->ProgramHeaders() * header->ProgramHeaderSize());
+    }
 
     ReadSections();
-    ReadProgramHeaders();
 
-    ReadSymbols();
+    if ( stream && options.lazy ) {
+        RetainSections();
+    }
+
+    if ( !options.lazy ) {
+        RequireProgramHeaders();
+        RequireSymbols();
+        RequireRelocations();
+        RequireTables();
+    }
+}
+
+void ElfParser::RequireSymbols() {
+    if ( !symbolsRead ) {
+        ReadSymbols();
+        symbolsRead = true;
+    }
+}
 
-    WriteStringTable();
-    UpdateSymbolTable();
+void ElfParser::RequireProgramHeaders() {
+    if ( !progHeadersRead ) {
+        ReadProgramHeaders();
+        progHeadersRead = true;
+    }
+}
+
+void ElfParser::RequireRelocations() {
+    if ( !relocationsRead ) {
+        ReadRelocations();
+        relocationsRead = true;
+    }
+}
+
+const RelocationStore& ElfParser::Relocations() {
+    RequireRelocations();
+    return relocationStore;
+}
+
+void ElfParser::RequireTables() {
+    if ( !tablesWritten ) {
+        // The new symbol table is written from the parsed symbols
+        RequireSymbols();
+        WriteStringTable();
+        UpdateSymbolTable();
+        tablesWritten = true;
+    }
+}
 
+const SymbolTable& ElfParser::Symbols() {
+    if ( !symbolColumns ) {
+        if ( symidx < 0 ) {
+            // stripped binary: an empty table
+            symbolColumns = arena->New<SymbolTable>(
+                reader.Begin(), 0, stringTable);
+        } else {
+            Section* symTable = sections[symidx];
+            symbolColumns = arena->New<SymbolTable>(
+                reader.Begin() + symTable->DataStart(),
+                symTable->NumItems(), 
+                stringTable);
+        }
+    }
+    return *symbolColumns;
 }
 
 void ElfParser::ReadSections() {
@@ -46,14 +137,19 @@ void ElfParser::ReadSections() {
     (tableStart + sidx*hdrSize).Read(&stableHeader, hdrSize);
 
     headerStrings =  stableHeader.sh_offset;
+    sectionNames = StringBlock(*input, 
+                               stableHeader.sh_offset, 
+                               stableHeader.sh_size,
+                               *arena);
     BinaryReader nextSection = tableStart;
 
     for ( int i=0; i<header->Sections(); ++i) {
-       sections[i] = new Section(nextSection, headerStrings);
-       if (sections[i]->Name() == ".symtab" ) symidx = i;
-       if (sections[i]->Name() == ".strtab" ) stridx = i;
+       sections[i] = arena->New<Section>(nextSection, sectionNames);
+       NameView name = sections[i]->NameRef();
+       if ( name == ".symtab" ) symidx = i;
+       if ( name == ".strtab" ) stridx = i;
        if (sections[i]->IsLInkSection() ) ++linkSections;
-       sectionMap[sections[i]->Name()] = i;
+       sectionMap.Set(name, i);
        nextSection += hdrSize;
 
        LOG_FROM ( 
@@ -64,7 +160,36 @@ void ElfParser::ReadSections() {
              + "\n" + sections[i]->Descripe()
        )
     }
-    stringTable = sections[stridx]->DataStart();
+    if ( stridx >= 0 ) {
+        stringTable = sections[stridx]->DataStart();
+    }
+}
+
+/*
+ * Keep the parts of a streamed file that PrintLink will need: the LINK
+ * sections, the symbol tables and the relocations. Everything else is dropped from the
+ * stream's window.
+ *
+ * The ranges are retained in ascending order, so that we never have to
+ * go back to data the stream has moved past.
+ */
+void ElfParser::RetainSections() {
+    vector<pair<long,long> > ranges;
+    for ( int i=0; i < (int)sections.size(); ++i ) {
+        Section* sec = sections[i];
+        if (    sec->IsLInkSection() || sec->IsRelocTable() 
+             || i == symidx || i == stridx ) 
+        {
+            ranges.push_back(make_pair(sec->DataStart(), sec->DataSize()));
+        }
+    }
+    sort(ranges.begin(), ranges.end());
+
+    for ( auto& range: ranges ) {
+        stream->Retain(range.first, range.second);
+    }
+
+    stream->Release(stream->Size());
 }
 
 void ElfParser::ReadProgramHeaders() {
@@ -75,33 +200,177 @@ void ElfParser::ReadProgramHeaders() {
     BinaryReader readPos =   reader.Begin() 
                            + header->ProgramHeadersStart();
 
+    // Every header needs to know which sections it holds
+    AddressIndex index(sections);
+
     for ( int i=0; i<header->ProgramHeaders(); ++i) {
-       progHeaders[i] = new ProgramHeader( readPos, sections);
+       progHeaders[i] = arena->New<ProgramHeader>( readPos, sections, index);
+    }
+}
+
+/*
+ * If we're reading from a mapped file, start bringing in sec's data in
+ * the background
+ */
+void ElfParser::Prefetch(Section* sec) {
+    if ( mappedFile ) {
+        mappedFile->Prefetch(sec->DataStart(), sec->DataSize());
     }
 }
 
 void ElfParser::ReadSymbols() {
+    if ( symidx < 0 ) {
+        // stripped binary: nothing to do
+        return;
+    }
     Section * symTable = sections[symidx];
-    symbols.resize(symTable->NumItems());
+    size_t count = symTable->NumItems();
+    symbols.assign(count, NULL);
+
+    // Get the kernel reading the names while we decode the symbols
+    Prefetch(symTable);
+    if ( stridx >= 0 ) {
+        Prefetch(sections[stridx]);
+        symbolNames = StringBlock(*input,
+                                  sections[stridx]->DataStart(),
+                                  sections[stridx]->DataSize(),
+                                  *arena);
+    }
+
+    BinaryReader tableStart = reader.Begin() + 
+                                symTable->DataStart();
+
+    // All of the symbols are stored in a single array, which is only
+    // handed over to the arena once every symbol has been constructed
+    symbolStore = arena->Allocate<Symbol>(count);
+
+    size_t threads = symbolThreads > 1 ? symbolThreads : 1;
+    if ( threads > count / MIN_SYMBOLS_PER_THREAD ) {
+        threads = count / MIN_SYMBOLS_PER_THREAD;
+    }
+
+    try {
+        if ( threads <= 1 ) {
+            linkSymbols = DecodeSymbols(tableStart, 0, count);
+        } else {
+            // Each thread decodes a contiguous chunk of the table into its
+            // own slice of the symbols array.
+            linkSymbols = 0;
+
+            size_t chunk = (count + threads - 1) / threads;
+            std::vector<int> links(threads, 0);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+
+            for ( size_t t=0; t < threads; ++t ) {
+                size_t begin = t * chunk;
+                size_t end = std::min(begin + chunk, count);
+                workers.push_back(std::thread(
+                    [=, &links, &errors, &tableStart] () {
+                        try {
+                            links[t] = DecodeSymbols(tableStart, begin, end);
+                        } catch ( ... ) {
+                            errors[t] = std::current_exception();
+                        }
+                    }));
+            }
+
+            for ( size_t t=0; t < threads; ++t ) {
+                workers[t].join();
+                linkSymbols += links[t];
+            }
+            for ( std::exception_ptr& error : errors ) {
+                if ( error ) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+    } catch ( ... ) {
+        // The arena never got to manage the store, so destroy whichever
+        // symbols were built before the failure
+        for ( Symbol*& sym : symbols ) {
+            if ( sym ) {
+                sym->~Symbol();
+                sym = NULL;
+            }
+        }
+        symbols.clear();
+        throw;
+    }
+
+    arena->Manage(symbolStore, count);
+
+    // Build the name index in table order, so that duplicate names resolve
+    // to the same symbol as a serial decode would
+    symbolMap.Reserve(count);
+    for ( size_t i=0; i < count; ++i) {
+        symbolMap.Set(symbols[i]->NameRef(), i);
+    }
+}
 
-    BinaryReader readPos = reader.Begin() + 
-                             symTable->DataStart();
+/*
+ * Copy every SHT_RELA table into the store, in order of the section the
+ * relocations apply to
+ */
+void ElfParser::ReadRelocations() {
+    vector<pair<Elf64_Word, Section*> > tables;
+    for ( Section* sec: sections ) {
+        if ( sec->IsRelocTable() && sec->DataSize() > 0 ) {
+            if ( sec->ItemSize() != sizeof(Elf64_Rela) ) {
+                throw "ElfParser: Unexpected relocation entry size in " +
+                      sec->Name();
+            }
+            tables.push_back(make_pair(sec->RelocTarget(), sec));
+        }
+    }
+    // Keep tables for the same section in file order
+    stable_sort(tables.begin(), tables.end(), 
+        [] (const pair<Elf64_Word,Section*>& lhs, 
+            const pair<Elf64_Word,Section*>& rhs) 
+        {
+            return lhs.first < rhs.first;
+        });
+
+    for ( auto& table: tables ) {
+        Section* sec = table.second;
+        relocationStore.Add(reader.Begin() + sec->DataStart(),
+                            sec->NumItems(),
+                            table.first);
+    }
+}
 
-for ( size_t i=0; i < symTable->NumItems(); ++i) {
-        symbols[i] = new Symbol(readPos,stringTable);
-        if ( symbols[i]->IsLinkSymbol() ) ++linkSymbols;
-        symbolMap[symbols[i]->Name()] = i;
+/*
+ * Decode symbols [begin, end) into the symbols array, returning the number
+ * of link symbols found. 
+ *
+ * Only touches its own slice of the array, so it is safe to run several
+ * disjoint ranges concurrently.
+ */
+int ElfParser::DecodeSymbols(const BinaryReader& tableStart,
+                             size_t begin,
+                             size_t end)
+{
+    int links = 0;
+    BinaryReader readPos = tableStart + begin * sizeof(Elf64_Sym);
+    for ( size_t i=begin; i < end; ++i) {
+        symbols[i] = new (symbolStore + i) Symbol(readPos,symbolNames);
+        if ( symbols[i]->IsLinkSymbol() ) ++links;
     }
+    return links;
 }
 
 ElfParser::~ElfParser () {
-    delete header;
-    for ( auto ptr : sections ) delete ptr;
-    for ( auto ptr : symbols ) delete ptr;
-    for ( auto ptr : progHeaders ) delete ptr;
+    // Everything we created is released by the arena
 }
 
 string ElfParser::PrintLink() {
+    RequireSymbols();
+    RequireRelocations();
+
+    ostringstream relocations;
+    size_t nrels = WriteLinkRelocations(relocations);
+
     ostringstream link;
     link << "# LINK formated file created from " << FileName();
     link << " by elf2link" << endl;
@@ -109,7 +378,7 @@ string ElfParser::PrintLink() {
 
     link << "# Header: nsegs, nsyms, nrels flags" << endl;
     link << LinkSections() << " " << LinkSymbols() << " ";
-    link << RelocCount() << " " << header->LinkFlags() << endl;
+    link << nrels << " " << header->LinkFlags() << endl;
 
     link << "# Section headers" << endl;
     for ( auto section: sections ) {
@@ -123,6 +392,9 @@ string ElfParser::PrintLink() {
             link << symbol->LinkFormat() << endl;
     }
 
+    link << "# Relocations" << endl;
+    link << relocations.str();
+
     link << "# section data" << endl;
     for ( auto section: sections ) {
         if ( section->IsLInkSection() )
@@ -131,14 +403,85 @@ string ElfParser::PrintLink() {
     return link.str();
 }
 
+int ElfParser::LinkRelocations() {
+    RequireSymbols();
+    RequireRelocations();
+
+    ostringstream ignored;
+    return WriteLinkRelocations(ignored);
+}
+
+/*
+ * LINK numbers segments and symbols by their position (from 1) among the
+ * sections and symbols it writes out, not by their ELF index. Relocations
+ * that patch a section, or refer to a symbol, that isn't written out
+ * can't be expressed, and are left out.
+ */
+size_t ElfParser::WriteLinkRelocations(ostream& link) {
+    vector<Elf64_Word> segmentNumbers(sections.size(), 0);
+    Elf64_Word segment = 0;
+    for ( size_t i = 0; i < sections.size(); ++i ) {
+        if ( sections[i]->IsLInkSection() ) {
+            segmentNumbers[i] = ++segment;
+        }
+    }
+
+    // Relocations against another symbol table (e.g. .dynsym) can't be
+    // written in terms of ours
+    for ( Section* sec: sections ) {
+        if (    sec->IsRelocTable()
+             && (long)sec->RelocSymbols() != symidx
+             && sec->RelocTarget() < segmentNumbers.size() )
+        {
+            segmentNumbers[sec->RelocTarget()] = 0;
+        }
+    }
+
+    vector<Elf64_Word> symbolNumbers(symbols.size(), 0);
+    Elf64_Word symbol = 0;
+    for ( size_t i = 0; i < symbols.size(); ++i ) {
+        if ( symbols[i]->IsLinkSymbol() ) {
+            symbolNumbers[i] = ++symbol;
+        }
+    }
+
+    size_t count = 0;
+    for ( size_t g=0; g < relocationStore.Sections(); ++g ) {
+        Elf64_Word target = relocationStore.SectionAt(g);
+        if ( target >= segmentNumbers.size() || segmentNumbers[target] == 0 ) {
+            continue;
+        }
+        RelocationStore::Range range = relocationStore.EntriesAt(g);
+        for ( const Elf64_Rela* rela = range.Begin(); 
+              rela != range.End(); 
+              ++rela ) 
+        {
+            Elf64_Xword ref = ELF64_R_SYM(rela->r_info);
+            if ( ref < symbolNumbers.size() && symbolNumbers[ref] != 0 ) {
+                link << Relocation::LinkFormat( *rela,
+                                                segmentNumbers[target],
+                                                symbolNumbers[ref]) << endl;
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
 ElfContent ElfParser::Content() {
+    // The caller gets the whole file...
+    RequireProgramHeaders();
+    RequireSymbols();
+    RequireTables();
+
     ElfContent content = {
         *(this->header),
         this->sections,
         this->progHeaders,
         this->symbols,
         this->sectionMap,
-        this->symbolMap
+        this->symbolMap,
+        this->input
 
     };
     return content;
@@ -146,19 +489,55 @@ ElfContent ElfParser::Content() {
 
 void ElfParser::WriteStringTable () {
     for ( Section* sec : sections ) {
-        if ( sec->Name().length() > 0 )
-            sec->NameOffset() = sh_strtab.AddString(sec->Name().c_str());
+        if ( !sec->NameRef().Empty() )
+            sec->NameOffset() = sh_strtab.AddString(sec->NameRef());
         else
             sec->NameOffset() = 0;
     }
     Section* shtab = Section::MakeNewStringTable(sh_strtab, &sh_strtab, ".shstrtab");
-    // Swap in the new string table
-    delete sections[sectionMap[".shstrtab"]];
-    sections[sectionMap[".shstrtab"]] = shtab;
+
+    // With every name added, the handles can be resolved to offsets
+    for ( Section* sec : sections ) {
+        sec->NameOffset() = sh_strtab.Offset(sec->NameOffset());
+    }
+    // Swap in the new string table (the old one is left to the arena)
+    int shidx = sectionMap.Find(".shstrtab");
+    if ( shidx == NameIndex::NOT_FOUND ) {
+        shidx = header->StringTableIndex();
+    }
+    sections[shidx] = arena->Adopt(shtab);
+}
+
+/*
+ * Replace .strtab with a tail merged copy, and point the symbols at their
+ * new names
+ */
+void ElfParser::WriteSymbolNames() {
+    StringTable names(StringTable::TAIL_MERGE);
+    for ( Symbol* sym : symbols ) {
+        sym->NameOffset() = names.AddString(sym->NameRef());
+    }
+
+    for ( Symbol* sym : symbols ) {
+        sym->NameOffset() = names.Offset(sym->NameOffset());
+    }
+
+    Section& strTable = *sections[stridx];
+    shared_ptr<Data> data = strTable.GetData();
+    data->Resize(names.Size());
+    names.WriteTable(data->Writer());
+    strTable.DataSize() = names.Size();
 }
 
 void ElfParser::UpdateSymbolTable() {
-    Section& symTable = *sections[sectionMap[".symtab"]];
+    if ( symidx < 0 ) {
+        return;
+    }
+    Section& symTable = *sections[symidx];
+
+    if ( mergeStringTables && stridx >= 0 ) {
+        WriteSymbolNames();
+    }
 
     if ( symbols.size() == 0 ) {
         symTable.DataSize() = 0;
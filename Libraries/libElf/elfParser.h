@@ -3,11 +3,57 @@
 #include <vector>
 #include "symbol.h"
 #include "programHeader.h"
-#include <forward_list>
 #include "reloc.h"
+#include "relocationStore.h"
 #include "binaryReader.h"
 #include "buildElf.h"
 #include "stringTable.h"
+#include "nameIndex.h"
+#include "elfArena.h"
+#include "symbolTable.h"
+#include "streamReader.h"
+#include "stringBlock.h"
+#include <memory>
+
+/**
+ * Options controlling how much work the ElfParser does up front
+ */
+struct ElfParserOptions {
+    ElfParserOptions()
+        : lazy(false), symbolThreads(1), arena(NULL), 
+          mergeStringTables(false) {}
+
+    /*
+     * Only read the ELF header and section headers in the constructor.
+     * Symbols, program headers, relocations and the re-generated string
+     * and symbol tables are built the first time something asks for 
+     * them.
+     *
+     * When reading from a StreamReader, a lazy parser only keeps the 
+     * parts of the file needed to print it (see PrintLink).
+     */
+    bool lazy;
+
+    /*
+     * Number of threads to decode the symbol table with. Small tables
+     * are always decoded on the calling thread.
+     */
+    int symbolThreads;
+
+    /*
+     * Allocate the parsed objects from a caller supplied arena, rather
+     * than the parser's own. The objects then live until the caller
+     * releases the arena, which must not happen before the parser is 
+     * destroyed.
+     */
+    ElfArena* arena;
+
+    /*
+     * Re-build .shstrtab and .strtab with names that are the tail of 
+     * another name stored inside it (see StringTable::TAIL_MERGE)
+     */
+    bool mergeStringTables;
+};
 
 /**
     \class   ElfParser
@@ -17,8 +63,11 @@
 class ElfParser {
 public:
     // C'tor / D'tor
-    ElfParser (const FileLikeReader &f);
-    ElfParser (FileLikeReader &&f): ElfParser(f){}
+    ElfParser (const FileLikeReader &f,
+               const ElfParserOptions& options = ElfParserOptions());
+    ElfParser (FileLikeReader &&f,
+               const ElfParserOptions& options = ElfParserOptions())
+        : ElfParser(f, options){}
     virtual ~ElfParser ();
 
     // Create a string representing the object file in LINK format
@@ -28,39 +77,96 @@ public:
     string FileName() { return filename; }
     int SegmentCount() { return sections.size(); }
     int LinkSections() { return linkSections; }
-    int SymbolCount() { return sections.size(); }
-    int LinkSymbols() { return linkSymbols; }
-    int RelocCount() { return 0; /*not yet implemented */}
+    int SymbolCount() { RequireSymbols(); return symbols.size(); }
+    int LinkSymbols() { RequireSymbols(); return linkSymbols; }
+    int RelocCount() { RequireRelocations(); return relocationStore.Size(); }
+    // The relocations PrintLink writes: those between LINK sections and symbols
+    int LinkRelocations();
+
+    /*
+     * Every SHT_RELA entry in the file, grouped by the section it 
+     * applies to
+     */
+    const RelocationStore& Relocations();
+
+    /*
+     * Column-wise view of the file's symbol table, read on first use.
+     * Independent of the Symbol objects: asking for it does not cause
+     * them to be parsed.
+     */
+    const SymbolTable& Symbols();
 
     ElfContent Content();
 
 protected:
     void ReadSymbols();
+    void ReadRelocations();
+    void Prefetch(Section* sec);
+    void RetainSections();
+    int  DecodeSymbols(const BinaryReader& tableStart,
+                       size_t begin,
+                       size_t end);
     void ReadProgramHeaders();
     void ReadSections();
     void WriteStringTable ();
     void UpdateSymbolTable ();
+    void WriteSymbolNames ();
+
+    /*
+     * Parse the relevant part of the file, if it hasn't been already
+     */
+    void RequireSymbols();
+    void RequireProgramHeaders();
+    void RequireRelocations();
+    void RequireTables();
+
+    /*
+     * Write the relocations in LINK format, returning how many there were
+     */
+    size_t WriteLinkRelocations(ostream& link);
 
 private:
+    // Every object we parse is allocated from here
+    unique_ptr<ElfArena> ownArena;
+    ElfArena* arena;
+
     BinaryReader reader;
     BinaryReader stringTable;
     BinaryReader headerStrings;
 
+    // Section and symbol names are views into these
+    StringBlock sectionNames;
+    StringBlock symbolNames;
+
+    const FileLikeReader* input;
+
+    // The input, if it is a mapped file we can give hints to
+    const ElfFileReader* mappedFile;
+
+    // The input, if it can only be read front to back
+    const StreamReader* stream;
+
     /* data */
     ElfHeaderX86_64 *header;
     std::vector<Section *> sections;
     std::vector<ProgramHeader *> progHeaders;
     std::vector<Symbol *> symbols;
-    std::map<string,int> sectionMap;
-    std::map<string,int> symbolMap;
+    Symbol* symbolStore;
+    SymbolTable* symbolColumns;
+    NameIndex sectionMap;
+    NameIndex symbolMap;
 
-    // We're want to rapidly add things, and only ever want to
-    // iterate through. 
-    std::forward_list<Relocation *> relocations;
+    RelocationStore relocationStore;
     int symidx;
     int stridx;
     int linkSections;
     int linkSymbols;
+    int symbolThreads;
+    bool symbolsRead;
+    bool progHeadersRead;
+    bool relocationsRead;
+    bool tablesWritten;
+    bool mergeStringTables;
     string filename;
     StringTable sh_strtab;
 };
@@ -2,27 +2,59 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <string>
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <cstdint>
 #include "elfReader.h"
 
 using namespace std;
 
 
 
-ElfFileReader::ElfFileReader ( const string &fname ):file(NULL) {
-    OpenFile(fname);
-}
+// Size of a transparent huge page on x86_64
+static const long HUGE_PAGE_SIZE = 2 * 1024 * 1024;
 
-void ElfFileReader::OpenFile ( const string &fname ) {
+ElfFileReader::ElfFileReader ( const string &fname, int hints )
+    : file(NULL), 
+      fd(-1),
+      mappedLength(0),
+      scan(ByteScan::Best())
+{
+    OpenFile(fname, hints);
+}
 
-    // kill the old file
-    if (file) {
-       munmap(file,size);
+void ElfFileReader::CloseFile () {
+    if ( fd >= 0 ) {
+        close(fd);
+        fd = -1;
+    }
+    if ( mapping ) {
+       // Someone else may still be using it
+       mapping.reset();
+       file = NULL;
+       this->size = 0;
+    } else if (file) {
+       munmap(file,mappedLength);
        file = NULL;
        this->size = 0;
+       this->mappedLength = 0;
+    }
+}
+
+void ElfFileReader::OpenFile ( const string &fname, int hints ) {
+
+    // kill the old file
+    CloseFile();
+
+    if ( hints & READ_CACHED ) {
+        mapping = MappingCache::Instance().Open(fname);
+        file = const_cast<char*>(mapping->Data());
+        sptr = mapping->Data();
+        size = mapping->Size();
+        return;
     }
 
     // Lets briefly pretend we're c programers
@@ -31,21 +63,160 @@ void ElfFileReader::OpenFile ( const string &fname ) {
     size=statBlock.st_size;
 
     FILE *fh = fopen(fname.c_str(),"rb");
-    file = mmap(NULL,size, PROT_READ, MAP_PRIVATE, fileno(fh), 0);
+    if ( !fh ) {
+        throw "ElfFileReader: Failed to open " + fname;
+    }
+
+    try {
+        if ( hints & READ_STAGE_HUGE_PAGES ) {
+            StageFile(fileno(fh), fname);
+        } else {
+            MapFile(fileno(fh), fname, hints);
+        }
+    } catch ( ... ) {
+        fclose(fh);
+        throw;
+    }
     sptr = reinterpret_cast<const char *>(file);
+
+    if ( hints & READ_STAGE_HUGE_PAGES ) {
+        // Already read in: nothing to hint about
+    } else if ( hints & READ_SEQUENTIAL ) {
+        madvise(file, size, MADV_SEQUENTIAL);
+        // Start pulling the file into the page cache now, rather than
+        // waiting for the first fault
+        readahead(fileno(fh), 0, size);
+    } else if ( hints & READ_RANDOM ) {
+        madvise(file, size, MADV_RANDOM);
+    }
+    fd = fcntl(fileno(fh), F_DUPFD_CLOEXEC, 0);
     fclose(fh);
 }
 
+/*
+ * Map the file directly from the page cache
+ */
+void ElfFileReader::MapFile(int fd, const string& fname, int hints) {
+    int flags = MAP_PRIVATE;
+    if ( hints & READ_POPULATE ) {
+        flags |= MAP_POPULATE;
+    }
+
+    void* addr = NULL;
+    if ( hints & READ_HUGE_PAGES ) {
+        // The kernel can only use a huge page for a 2MiB aligned block of
+        // the mapping, so find an aligned address for the file to go to
+        addr = ReserveHugeAligned(size);
+        if ( addr ) {
+            flags |= MAP_FIXED;
+        }
+    }
+
+    file = mmap(addr, size, PROT_READ, flags, fd, 0);
+    if ( file == MAP_FAILED ) {
+        if ( addr ) {
+            munmap(addr, size);
+        }
+        file = NULL;
+        throw "ElfFileReader: Failed to map " + fname;
+    }
+    mappedLength = size;
+
+    if ( hints & READ_HUGE_PAGES ) {
+        // Only honoured by kernels with huge page support for read-only
+        // file mappings; otherwise we just get normal pages
+        madvise(file, size, MADV_HUGEPAGE);
+    }
+}
+
+/*
+ * Copy the file into an anonymous mapping backed by huge pages: 
+ * explicitly reserved (hugetlbfs) ones if the system has them, otherwise
+ * transparent huge pages.
+ */
+void ElfFileReader::StageFile(int fd, const string& fname) {
+    long length = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+    if ( length == 0 ) {
+        length = HUGE_PAGE_SIZE;
+    }
+
+    void* addr = mmap(NULL, length, PROT_READ | PROT_WRITE, 
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if ( addr == MAP_FAILED ) {
+        addr = ReserveHugeAligned(length);
+        if ( !addr ) {
+            throw "ElfFileReader: Failed to allocate a buffer for " + fname;
+        }
+        madvise(addr, length, MADV_HUGEPAGE);
+    }
+    file = addr;
+    mappedLength = length;
+
+    char* dest = reinterpret_cast<char*>(addr);
+    for ( long done = 0; done < size; ) {
+        ssize_t got = pread(fd, dest + done, size - done, done);
+        if ( got <= 0 ) {
+            CloseFile();
+            throw "ElfFileReader: Failed to read " + fname;
+        }
+        done += got;
+    }
+
+    mprotect(addr, length, PROT_READ);
+}
+
+/*
+ * Reserve an anonymous, writeable, block of length bytes starting on a
+ * huge page boundary. Over-allocate, then trim back to the aligned part.
+ */
+void* ElfFileReader::ReserveHugeAligned(long length) {
+    long reserved = length + HUGE_PAGE_SIZE;
+    void* block = mmap(NULL, reserved, PROT_READ | PROT_WRITE, 
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if ( block == MAP_FAILED ) {
+        return NULL;
+    }
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(block);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t end = aligned + ((length + pageSize - 1) / pageSize) * pageSize;
+
+    if ( aligned > start ) {
+        munmap(block, aligned - start);
+    }
+    if ( start + reserved > end ) {
+        munmap(reinterpret_cast<void*>(end), start + reserved - end);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+void ElfFileReader::Prefetch(long offset, long length) const {
+    if ( offset < 0 || offset >= size || length <= 0 ) {
+        return;
+    }
+    if ( offset + length > size ) {
+        length = size - offset;
+    }
+
+    // madvise needs a page aligned address
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    long start = offset - (offset % pageSize);
+    madvise(const_cast<char*>(sptr) + start, 
+            length + (offset - start), 
+            MADV_WILLNEED);
+}
+
 ElfFileReader::~ElfFileReader () {
     // kill the old file
-    if (file) {
-       munmap(file,size);
-    }
+    CloseFile();
 }
 
 void ElfFileReader::ReadString(long offset, string &dest) const {
     const char * str = this->sptr + offset;
-    dest=str;
+    const char * end = scan.Find(str, sptr + size, '\0');
+    dest.assign(str, end - str);
 }
 void ElfFileReader::Read(long offset, void *dest, long size) const {
     memcpy(dest,sptr + offset,size);
@@ -61,16 +232,45 @@ long ElfFileReader::Size() const {
 
 long ElfFileReader::Next( long offset, unsigned char c) const
 {
-    for (long i = offset; i < size; ++i) {
-        if ( c == sptr[i]) return i;
+    long pos = Size();
+    if ( offset < size ) {
+        pos = scan.Find(sptr + offset, sptr + size, c) - sptr;
     }
-    return Size();
+    return pos;
 }
 
+/*
+ * Search back from offset, stopping before the first byte of the file
+ */
 long ElfFileReader::Last( long offset, unsigned char c) const
 {
-    for (long i = offset; i > 0; --i) {
-        if ( c == sptr[i]) return i;
+    if ( offset >= size ) {
+        offset = size - 1;
+    }
+
+    long pos = 0;
+    if ( offset > 0 ) {
+        const char* found = scan.FindLast(sptr + 1, sptr + offset + 1, c);
+        if ( found ) {
+            pos = found - sptr;
+        }
+    }
+    return pos;
+}
+
+size_t ElfFileReader::FindAll( long offset, 
+                               long count, 
+                               unsigned char c, 
+                               vector<long>& found) const
+{
+    if ( offset + count > size ) {
+        count = size - offset;
+    }
+
+    size_t start = found.size();
+    size_t matches = scan.FindAll(sptr + offset, sptr + offset + count, c, found);
+    for ( size_t i = start; i < found.size(); ++i ) {
+        found[i] += offset;
     }
-    return 0;
+    return matches;
 }
@@ -2,6 +2,9 @@
 #define ElfFileReader_H
 
 #include "binaryReader.h"
+#include "byteScan.h"
+#include "mappingCache.h"
+#include <vector>
 
 using namespace std;
 
@@ -13,22 +16,79 @@ using namespace std;
 */
 class ElfFileReader: public FileLikeReader {
 public:
-    ElfFileReader (const string &fname);
+    /*
+     * Hints about how the file will be read, passed to the kernel when
+     * the file is mapped. Combine with |.
+     */
+    enum ReadHints {
+        READ_DEFAULT = 0,
+        // The file will be read front to back: read ahead aggressively,
+        // and start reading the whole file in as soon as it is opened
+        READ_SEQUENTIAL = 1,
+        // Small reads all over the file: don't read ahead
+        READ_RANDOM = 2,
+        // Fault the whole file in before the constructor returns
+        READ_POPULATE = 4,
+        // Map the file on a huge page boundary, and ask for it to be 
+        // backed by transparent huge pages
+        READ_HUGE_PAGES = 8,
+        // Copy the file into an anonymous huge page backed buffer, 
+        // rather than mapping it. Costs a copy up front, but guarantees
+        // large pages when the file system can't provide them.
+        READ_STAGE_HUGE_PAGES = 16,
+        // Share a mapping from the MappingCache with every other reader 
+        // of the same file. The other hints are ignored: the mapping is
+        // shared, so we don't get to choose how it is set up.
+        READ_CACHED = 32
+    };
+
+    ElfFileReader (const string &fname, int hints = READ_DEFAULT);
     virtual ~ElfFileReader();
 
+    /*
+     * Ask the kernel to start reading [offset, offset+size) in the 
+     * background, so that it is (hopefully) in memory by the time we get
+     * there.
+     */
+    void Prefetch(long offset, long size) const;
+
     virtual void Read(long offset, void *dest, long size) const;
     virtual void ReadString(long offset, string& dest) const;
     virtual unsigned char Get(long offset) const;
 
     virtual long Size() const;
+
+    // The mapped file
+    const char* Data() const { return sptr; }
+
+    // A descriptor for the file, kept open for copying straight from it
+    int Fd() const { return mapping ? mapping->Fd() : fd; }
     virtual long Next( long offset, unsigned char c) const;
     virtual long Last( long offset, unsigned char c) const;
 
+    /*
+     * Append the file offset of every c in [offset, offset+size) to found,
+     * in a single pass. Useful for splitting a string table into its 
+     * strings.
+     */
+    size_t FindAll( long offset, 
+                    long size, 
+                    unsigned char c, 
+                    vector<long>& found) const;
 
 private:
-    void OpenFile(const string &fname);
+    void OpenFile(const string &fname, int hints);
+    void CloseFile();
+    void MapFile(int fd, const string& fname, int hints);
+    void StageFile(int fd, const string& fname);
+    static void* ReserveHugeAligned(long length);
+
     void *file;
+    int fd;
+    long mappedLength;
+    shared_ptr<const ElfMapping> mapping;
     const char * sptr;
     long size;
+    const ByteScan& scan;
 };
 #endif
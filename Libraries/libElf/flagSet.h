@@ -0,0 +1,85 @@
+#ifndef FLAG_SET_H
+#define FLAG_SET_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+/*
+ * One flag in a FlagSet: how LINK writes it, and what it is called
+ */
+struct FlagDescriptor {
+    char letter;
+    const char* name;
+};
+
+/**
+    \class   FlagSet
+    \brief   A set of flags, stored as a plain bitmask
+    \details The flags a set may hold are described at compile time by
+             Traits::descriptors, a constexpr array of FlagDescriptors:
+             flag i in the table is bit i of the mask. Setting or testing
+             a flag is a single bit operation, and LinkMask() lists the
+             letters of the set flags in table order.
+
+             Traits::descriptors needs a (namespace scope) definition in
+             one translation unit, since LinkMask indexes it at run time.
+*/
+template <class Traits>
+class FlagSet {
+public:
+    typedef uint32_t Mask;
+
+    static constexpr size_t COUNT =
+        sizeof(Traits::descriptors) / sizeof(FlagDescriptor);
+    static_assert(COUNT <= 32, "Too many flags for a FlagSet");
+
+    // The mask for flag i in the table
+    static constexpr Mask Bit(size_t i) { return Mask(1) << i; }
+
+    // The mask for the first flag written as letter (0 if there isn't one)
+    static constexpr Mask Letter(char letter, size_t i = 0) {
+        return i >= COUNT ? 0 :
+               Traits::descriptors[i].letter == letter ? Bit(i) :
+               Letter(letter, i + 1);
+    }
+
+    constexpr FlagSet(): mask(0) {}
+    constexpr explicit FlagSet(Mask m): mask(m) {}
+
+    bool Test(Mask m) const { return (mask & m) != 0; }
+    Mask Raw() const { return mask; }
+
+    void Set(Mask m) { mask |= m; }
+    void Set(Mask m, bool on) {
+        mask = (mask & ~m) | (m & -Mask(on));
+    }
+
+    // Set the flags named by a LINK string (e.g "WA"). Unknown letters
+    // are ignored.
+    void SetLetters(const string& letters) {
+        for ( char c : letters ) {
+            mask |= Letter(c);
+        }
+    }
+
+    // The LINK representation: the letters of each set flag
+    string LinkMask() const {
+        string letters;
+        for ( size_t i = 0; i < COUNT; ++i ) {
+            if ( mask & Bit(i) ) {
+                letters += Traits::descriptors[i].letter;
+            }
+        }
+        return letters;
+    }
+
+private:
+    Mask mask;
+};
+
+template <class Traits>
+constexpr size_t FlagSet<Traits>::COUNT;
+
+#endif
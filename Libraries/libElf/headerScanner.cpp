@@ -0,0 +1,111 @@
+#include "headerScanner.h"
+#include "elfReader.h"
+#include "byteScan.h"
+#include <cstdint>
+#include <cstring>
+
+ElfHeaderScanner::ElfHeaderScanner(const FileLikeReader& f)
+    : file(f),
+      mapped(NULL),
+      fileSize(f.Size()),
+      header(NULL),
+      segments(NULL),
+      segmentCount(0),
+      sections(NULL),
+      sectionCount(0),
+      names(""),
+      namesSize(0)
+{
+    const ElfFileReader* mappedFile = dynamic_cast<const ElfFileReader*>(&f);
+    if ( mappedFile ) {
+        mapped = mappedFile->Data();
+    }
+
+    header = reinterpret_cast<const Elf64_Ehdr*>(
+        Table(0, sizeof(Elf64_Ehdr), alignof(Elf64_Ehdr),
+              headerCopy, "file header"));
+
+    if (    memcmp(header->e_ident, ELFMAG, SELFMAG) != 0
+         || header->e_ident[EI_CLASS] != ELFCLASS64 )
+    {
+        throw string("ElfHeaderScanner: Not a 64 bit ELF file");
+    }
+
+    if ( header->e_phnum > 0 ) {
+        if ( header->e_phentsize != sizeof(Elf64_Phdr) ) {
+            throw string("ElfHeaderScanner: Unexpected program header size");
+        }
+        segmentCount = header->e_phnum;
+        segments = reinterpret_cast<const Elf64_Phdr*>(
+            Table(header->e_phoff, segmentCount * sizeof(Elf64_Phdr),
+                  alignof(Elf64_Phdr), segmentsCopy, "program headers"));
+    }
+
+    if ( header->e_shnum > 0 ) {
+        if ( header->e_shentsize != sizeof(Elf64_Shdr) ) {
+            throw string("ElfHeaderScanner: Unexpected section header size");
+        }
+        sectionCount = header->e_shnum;
+        sections = reinterpret_cast<const Elf64_Shdr*>(
+            Table(header->e_shoff, sectionCount * sizeof(Elf64_Shdr),
+                  alignof(Elf64_Shdr), sectionsCopy, "section headers"));
+
+        if ( header->e_shstrndx != SHN_UNDEF &&
+             header->e_shstrndx < sectionCount )
+        {
+            const Elf64_Shdr& strings = sections[header->e_shstrndx];
+            names = Table(strings.sh_offset, strings.sh_size, 1,
+                          namesCopy, "section names");
+            namesSize = strings.sh_size;
+        }
+    }
+}
+
+/*
+ * Find [offset, offset+size) in the file: in place if we can, otherwise
+ * copied into copy.
+ */
+const char* ElfHeaderScanner::Table( long offset,
+                                     long size,
+                                     size_t align,
+                                     vector<char>& copy,
+                                     const char* what)
+{
+    if ( offset < 0 || size < 0 || offset > fileSize ||
+         size > fileSize - offset )
+    {
+        throw string("ElfHeaderScanner: File is too short for the ") + what;
+    }
+
+    const char* start = NULL;
+    if ( mapped && reinterpret_cast<uintptr_t>(mapped + offset) % align == 0) {
+        start = mapped + offset;
+    } else if ( size > 0 ) {
+        copy.resize(size);
+        file.Read(offset, &copy[0], size);
+        start = &copy[0];
+    } else {
+        start = "";
+    }
+    return start;
+}
+
+NameView ElfHeaderScanner::SectionName(size_t i) const {
+    NameView name;
+    long offset = sections[i].sh_name;
+    if ( offset < namesSize ) {
+        const char* start = names + offset;
+        const char* end = ByteScan::Best().Find(start, names + namesSize, '\0');
+        name = NameView(start, end - start);
+    }
+    return name;
+}
+
+long ElfHeaderScanner::FindSection(NameView name) const {
+    for ( size_t i = 0; i < sectionCount; ++i ) {
+        if ( SectionName(i) == name ) {
+            return i;
+        }
+    }
+    return NOT_FOUND;
+}
@@ -0,0 +1,87 @@
+#ifndef ELF_HEADER_SCANNER_H
+#define ELF_HEADER_SCANNER_H
+#include <elf.h>
+#include <vector>
+#include "binaryReader.h"
+#include "nameView.h"
+
+using namespace std;
+
+/**
+    \class   ElfHeaderScanner
+    \brief   Read-only view of an ELF file's header, program header table
+             and section header table
+    \details A fast path for questions that don't need the rest of the
+             file (type, entry point, segment layout, is there a .symtab?):
+             no Section, Symbol or ProgramHeader objects are built.
+
+             If the file is mapped (ElfFileReader) the tables are used
+             where they lie in the mapping. Otherwise, or if a table is
+             mis-aligned, it is copied once into the scanner.
+
+             Throws a string if the file isn't a 64 bit ELF file, or if a
+             table runs off the end of the file.
+*/
+class ElfHeaderScanner {
+public:
+    static const long NOT_FOUND = -1;
+
+    ElfHeaderScanner(const FileLikeReader& file);
+
+    // The file header
+    const Elf64_Ehdr& Header() const { return *header; }
+    Elf64_Half Type() const { return header->e_type; }
+    Elf64_Half Machine() const { return header->e_machine; }
+    Elf64_Addr EntryAddress() const { return header->e_entry; }
+
+    // The program header table
+    size_t Segments() const { return segmentCount; }
+    const Elf64_Phdr& Segment(size_t i) const { return segments[i]; }
+
+    // The section header table
+    size_t Sections() const { return sectionCount; }
+    const Elf64_Shdr& SectionEntry(size_t i) const { return sections[i]; }
+
+    /*
+     * The name of section i, from the section header string table.
+     * Sections with no (or a bad) name give an empty view.
+     */
+    NameView SectionName(size_t i) const;
+
+    /*
+     * Index of the first section called name, or NOT_FOUND
+     */
+    long FindSection(NameView name) const;
+    long FindSection(const char* name) const {
+        return FindSection(NameView(name));
+    }
+    bool HasSection(const char* name) const {
+        return FindSection(name) != NOT_FOUND;
+    }
+
+private:
+    const char* Table( long offset,
+                       long size,
+                       size_t align,
+                       vector<char>& copy,
+                       const char* what);
+
+    const FileLikeReader& file;
+    const char* mapped;
+    long fileSize;
+
+    const Elf64_Ehdr* header;
+    const Elf64_Phdr* segments;
+    size_t segmentCount;
+    const Elf64_Shdr* sections;
+    size_t sectionCount;
+    const char* names;
+    long namesSize;
+
+    // Only used if the file isn't mapped
+    vector<char> headerCopy;
+    vector<char> segmentsCopy;
+    vector<char> sectionsCopy;
+    vector<char> namesCopy;
+};
+#endif
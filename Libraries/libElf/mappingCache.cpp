@@ -0,0 +1,130 @@
+#include "mappingCache.h"
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+
+using namespace std;
+
+ElfMapping::ElfMapping(const string& p, int f, long s) 
+    : path(p), fd(f), size(s), data(NULL)
+{
+    if ( size > 0 ) {
+        void* addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( addr == MAP_FAILED ) {
+            close(fd);
+            throw "ElfMapping: Failed to map " + path + ": " + strerror(errno);
+        }
+        data = reinterpret_cast<const char*>(addr);
+    }
+}
+
+ElfMapping::~ElfMapping() {
+    if ( data ) {
+        munmap(const_cast<char*>(data), size);
+    }
+    close(fd);
+}
+
+MappingCache& MappingCache::Instance() {
+    static MappingCache cache;
+    return cache;
+}
+
+MappingCache::MappingCache(size_t l) 
+    : limit(l), mappedBytes(0)
+{
+}
+
+shared_ptr<const ElfMapping> MappingCache::Open(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if ( fd < 0 ) {
+        throw "MappingCache: Failed to open " + path + ": " + strerror(errno);
+    }
+
+    // fstat, rather than stat, so that the identity is of the file we
+    // actually opened
+    struct stat statBlock;
+    if ( fstat(fd, &statBlock) != 0 ) {
+        close(fd);
+        throw "MappingCache: Failed to stat " + path + ": " + strerror(errno);
+    }
+    FileId id = { statBlock.st_dev, statBlock.st_ino };
+
+    lock_guard<mutex> guard(lock);
+
+    auto it = entries.find(id);
+    if ( it != entries.end() ) {
+        Entry& entry = it->second;
+        if (    entry.mtime == statBlock.st_mtim.tv_sec 
+             && entry.mtimeNs == statBlock.st_mtim.tv_nsec
+             && entry.size == statBlock.st_size ) 
+        {
+            close(fd);
+            lru.splice(lru.begin(), lru, entry.lru);
+            return entry.mapping;
+        }
+
+        // The file has changed since we mapped it
+        Remove(it);
+    }
+
+    Entry entry;
+    entry.mapping.reset(new ElfMapping(path, fd, statBlock.st_size));
+    entry.mtime = statBlock.st_mtim.tv_sec;
+    entry.mtimeNs = statBlock.st_mtim.tv_nsec;
+    entry.size = statBlock.st_size;
+    entry.lru = lru.insert(lru.begin(), id);
+    entries[id] = entry;
+    mappedBytes += entry.size;
+
+    shared_ptr<const ElfMapping> mapping = entry.mapping;
+    Evict();
+
+    return mapping;
+}
+
+void MappingCache::Remove(map<FileId, Entry>::iterator it) {
+    mappedBytes -= it->second.size;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+}
+
+/*
+ * Drop the least recently used mappings until we're back under the limit
+ */
+void MappingCache::Evict() {
+    while ( mappedBytes > limit && !lru.empty() ) {
+        Remove(entries.find(lru.back()));
+    }
+}
+
+void MappingCache::SetLimit(size_t bytes) {
+    lock_guard<mutex> guard(lock);
+    limit = bytes;
+    Evict();
+}
+
+size_t MappingCache::Limit() {
+    lock_guard<mutex> guard(lock);
+    return limit;
+}
+
+size_t MappingCache::MappedBytes() {
+    lock_guard<mutex> guard(lock);
+    return mappedBytes;
+}
+
+size_t MappingCache::Entries() {
+    lock_guard<mutex> guard(lock);
+    return entries.size();
+}
+
+void MappingCache::Clear() {
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    lru.clear();
+    mappedBytes = 0;
+}
@@ -0,0 +1,111 @@
+#ifndef MAPPING_CACHE_H
+#define MAPPING_CACHE_H
+#include <string>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <list>
+#include <sys/types.h>
+
+using namespace std;
+
+/**
+    \class   ElfMapping
+    \brief   A read only mapping of a whole file
+    \details The file is unmapped, and its descriptor closed, when the last
+             reference goes. The descriptor is kept open so that the file
+             can be copied (e.g. with copy_file_range) without being 
+             re-opened.
+*/
+class ElfMapping {
+public:
+    ~ElfMapping();
+
+    const char* Data() const { return data; }
+    long Size() const { return size; }
+    int Fd() const { return fd; }
+    const string& Path() const { return path; }
+
+private:
+    friend class MappingCache;
+    ElfMapping(const string& path, int fd, long size);
+
+    ElfMapping(const ElfMapping&) = delete;
+    ElfMapping& operator=(const ElfMapping&) = delete;
+
+    string path;
+    int fd;
+    long size;
+    const char* data;
+};
+
+/**
+    \class   MappingCache
+    \brief   Process wide cache of file mappings
+    \details Opening the same file twice hands back the same mapping,
+             rather than opening and mapping it again. Files are identified
+             by device and inode; if the file has been modified (its mtime
+             or size have changed) it is mapped again.
+
+             The cache holds at most Limit() bytes of mappings, dropping
+             the least recently used first. A mapping dropped from the 
+             cache stays valid for as long as someone holds a reference.
+
+             All functions are thread safe.
+*/
+class MappingCache {
+public:
+    static const size_t DEFAULT_LIMIT = 1024UL * 1024UL * 1024UL;
+
+    static MappingCache& Instance();
+
+    /*
+     * Get a mapping of path, throwing if it can't be opened
+     */
+    shared_ptr<const ElfMapping> Open(const string& path);
+
+    /*
+     * Change the most bytes the cache will keep mapped, evicting as
+     * needed
+     */
+    void SetLimit(size_t bytes);
+    size_t Limit();
+
+    // Bytes currently held by the cache
+    size_t MappedBytes();
+    size_t Entries();
+
+    // Drop everything
+    void Clear();
+
+    MappingCache(size_t limit = DEFAULT_LIMIT);
+
+private:
+    struct FileId {
+        dev_t dev;
+        ino_t ino;
+        bool operator<(const FileId& rhs) const {
+            return dev < rhs.dev || (dev == rhs.dev && ino < rhs.ino);
+        }
+    };
+
+    struct Entry {
+        shared_ptr<const ElfMapping> mapping;
+        time_t mtime;
+        long mtimeNs;
+        long size;
+        list<FileId>::iterator lru;
+    };
+
+    void Evict();
+    void Remove(map<FileId, Entry>::iterator it);
+
+    mutex lock;
+    size_t limit;
+    size_t mappedBytes;
+    map<FileId, Entry> entries;
+
+    // Most recently used at the front
+    list<FileId> lru;
+};
+#endif
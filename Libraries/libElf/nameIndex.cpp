@@ -0,0 +1,132 @@
+#include "nameIndex.h"
+#include <cstring>
+
+using namespace std;
+
+const int NameIndex::NOT_FOUND;
+const int NameIndex::EMPTY_SLOT;
+
+NameIndex::NameIndex () {
+    Grow(16);
+}
+
+NameIndex::NameIndex (const NameIndex& rhs) 
+    : slots(rhs.slots), 
+      mask(rhs.mask), 
+      entries(rhs.entries),
+      pool(rhs.pool)
+{
+    for ( Entry& entry: entries ) {
+        entry.index = this;
+    }
+}
+
+NameIndex& NameIndex::operator=(const NameIndex& rhs) {
+    slots = rhs.slots;
+    mask = rhs.mask;
+    entries = rhs.entries;
+    pool = rhs.pool;
+    for ( Entry& entry: entries ) {
+        entry.index = this;
+    }
+    return *this;
+}
+
+/*
+ * 64 bit FNV-1a: cheap, and good enough for identifier names
+ */
+uint64_t NameIndex::Hash(const char* name, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for ( size_t i=0; i < length; ++i ) {
+        hash ^= (unsigned char) name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * Find the slot holding name, or the empty slot where it should go
+ */
+size_t NameIndex::Slot(uint64_t hash, const char* name, size_t length) const
+{
+    size_t slot = hash & mask;
+    while ( slots[slot] != EMPTY_SLOT ) {
+        const Entry& entry = entries[slots[slot]];
+        if (    entry.hash == hash 
+             && entry.length == length 
+             && memcmp(pool.data() + entry.offset, name, length) == 0 )
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void NameIndex::Grow(size_t slotCount) {
+    slots.assign(slotCount,EMPTY_SLOT);
+    mask = slotCount -1;
+
+    // We cached the hashes, so there is no need to look at the names
+    for ( size_t i=0; i < entries.size(); ++i ) {
+        size_t slot = entries[i].hash & mask;
+        while ( slots[slot] != EMPTY_SLOT ) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = i;
+    }
+}
+
+void NameIndex::Reserve(size_t count) {
+    // Keep the load factor at or below 1/2
+    size_t slotCount = slots.size();
+    while ( slotCount < 2 * count ) {
+        slotCount *= 2;
+    }
+    if ( slotCount != slots.size() ) {
+        Grow(slotCount);
+    }
+    entries.reserve(count);
+}
+
+void NameIndex::Set(const char* name, size_t length, int value) {
+    uint64_t hash = Hash(name,length);
+    size_t slot = Slot(hash,name,length);
+
+    if ( slots[slot] != EMPTY_SLOT ) {
+        entries[slots[slot]].value = value;
+    } else {
+        Entry entry;
+        entry.index = this;
+        entry.hash = hash;
+        entry.offset = pool.size();
+        entry.length = length;
+        entry.value = value;
+
+        pool.insert(pool.end(), name, name + length);
+        slots[slot] = entries.size();
+        entries.push_back(entry);
+
+        if ( 2 * entries.size() > slots.size() ) {
+            Grow(2 * slots.size());
+        }
+    }
+}
+
+int NameIndex::Find(const char* name, size_t length) const {
+    size_t slot = Slot(Hash(name,length),name,length);
+    if ( slots[slot] != EMPTY_SLOT ) {
+        return entries[slots[slot]].value;
+    } else {
+        return NOT_FOUND;
+    }
+}
+
+bool NameIndex::operator==(const NameIndex& rhs) const {
+    bool same = ( Size() == rhs.Size() );
+    for ( auto it = begin(); same && it != end(); ++it ) {
+        const char* name = pool.data() + it->offset;
+        same = ( rhs.Find(name, it->length) == it->value );
+    }
+    return same;
+}
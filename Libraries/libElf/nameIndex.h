@@ -0,0 +1,108 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "nameView.h"
+
+using namespace std;
+
+/**
+    \class   NameIndex
+    \brief   Look up the position of a named item (section, symbol...) 
+             in its table
+    \details Open addressing hash table (linear probing) from a name to an
+             int. 
+
+             The names themselves are copied into a single character pool,
+             rather than one std::string per entry, so building an index
+             of a million symbols costs a handful of allocations rather
+             than a million. Each slot also caches the full hash of its
+             name, so a lookup only compares characters on a hash match.
+
+             Iteration visits names in the order they were first added.
+*/
+class NameIndex {
+public:
+    static const int NOT_FOUND = -1;
+
+    class Entry {
+    public:
+        string Name() const { return string(index->pool.data() + offset, length); }
+        int Index() const { return value; }
+    private:
+        friend class NameIndex;
+        const NameIndex* index;
+        uint64_t hash;
+        size_t offset;
+        size_t length;
+        int value;
+    };
+    typedef vector<Entry>::const_iterator const_iterator;
+
+    NameIndex ();
+
+    /*
+     * Map name to value, replacing any existing value for name
+     */
+    void Set(const char* name, size_t length, int value);
+    void Set(const string& name, int value) {
+        Set(name.c_str(), name.length(), value);
+    }
+    void Set(const NameView& name, int value) {
+        Set(name.Data(), name.Length(), value);
+    }
+    void Set(const char* name, int value) {
+        Set(name, strlen(name), value);
+    }
+
+    /*
+     * Find the value for name, or NOT_FOUND
+     */
+    int Find(const char* name, size_t length) const;
+    int Find(const string& name) const {
+        return Find(name.c_str(), name.length());
+    }
+    int Find(const NameView& name) const {
+        return Find(name.Data(), name.Length());
+    }
+    int Find(const char* name) const {
+        return Find(name, strlen(name));
+    }
+
+    /*
+     * Size the table to hold count names without re-hashing
+     */
+    void Reserve(size_t count);
+
+    size_t Size() const { return entries.size(); }
+
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    // Same names, mapped to the same values
+    bool operator==(const NameIndex& rhs) const;
+    bool operator!=(const NameIndex& rhs) const { return !(*this == rhs); }
+
+    // The index holds pointers back to itself
+    NameIndex (const NameIndex& rhs);
+    NameIndex& operator=(const NameIndex& rhs);
+
+private:
+    static uint64_t Hash(const char* name, size_t length);
+    size_t Slot(uint64_t hash, const char* name, size_t length) const;
+    void Grow(size_t slotCount);
+
+    static const int EMPTY_SLOT = -1;
+
+    // Each slot holds an index into entries, or EMPTY_SLOT
+    vector<int> slots;
+    size_t mask;
+
+    vector<Entry> entries;
+    vector<char> pool;
+};
+
+#endif
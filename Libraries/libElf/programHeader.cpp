@@ -1,5 +1,6 @@
 #include "programHeader.h"
 #include "section.h"
+#include "addressIndex.h"
 #include <sstream>
 #include "binaryReader.h"
 #include <algorithm>
@@ -14,52 +15,36 @@ RawProgramHeader::RawProgramHeader(const Elf64_Phdr& other)
 
 ProgramHeader::ProgramHeader ( BinaryReader& reader, 
                                const SECTION_ARRAY& sections ) 
-    :flags("")
+    : ProgramHeader(reader, sections, AddressIndex(sections))
+{
+}
+
+ProgramHeader::ProgramHeader ( BinaryReader& reader, 
+                               const SECTION_ARRAY& sections,
+                               const AddressIndex& index )
 {
     reader >> (Elf64_Phdr&)(*this);
 
+    vector<size_t> contained = index.SectionsWithin(DataStart(), DataEnd());
 
-    // While this isn't terribly efficient, there's only going to
-    // be 20-30 sections a file...
-    for ( auto s : sections) {
-        if ( DataStart() <= s->DataStart() &&
-             DataEnd()   >= s->DataEnd() )
-        {
-            sectionNames.insert(sectionNames.begin(), s->Name());
-        }
+    // Last section first
+    sectionNames.reserve(contained.size());
+    for ( auto it = contained.rbegin(); it != contained.rend(); ++it ) {
+        sectionNames.push_back(sections[*it]->Name());
     }
     InitialiseFlags();
 
-    p_filesz = CalculateFileSize(sections);
+    p_filesz = CalculateFileSize(sections, contained);
 }
 
-Flags::Mask ProgramHeader::Flags_Executable  = Flags::EmptyMask;
-Flags::Mask ProgramHeader::Flags_Writeable   = Flags::EmptyMask;
-Flags::Mask ProgramHeader::Flags_Readable    = Flags::EmptyMask;
-
-const Flags& ProgramHeader::TypeFlags() {
-    static unique_ptr<Flags> flags = NULL;
-
-    if ( !flags) {
-        flags = unique_ptr<Flags>(new Flags(""));
-
-        ProgramHeader::Flags_Executable = 
-            flags->AddFlag('X', "Executable");
-        ProgramHeader::Flags_Writeable = 
-            flags->AddFlag('W', "Writeable");
-        ProgramHeader::Flags_Readable = 
-            flags->AddFlag('R', "Readable");
-    }
-    return *flags;
-}
+constexpr FlagDescriptor SegmentFlagTraits::descriptors[];
 
 void ProgramHeader::InitialiseFlags() {
-    if ( this->p_flags & PF_X ) 
-        flags.SetFlags(Flags_Executable, 1);
-    if ( this->p_flags & PF_W ) 
-        flags.SetFlags(Flags_Writeable, 1);
-    if ( this->p_flags & PF_R ) 
-        flags.SetFlags(Flags_Readable, 1);
+    static_assert( Flags_Executable == PF_X &&
+                   Flags_Writeable == PF_W &&
+                   Flags_Readable == PF_R,
+                   "Segment flags don't match elf.h");
+    flags = SegmentFlags(p_flags & (PF_X | PF_W | PF_R));
 }
 
 string RawProgramHeader::Describe() const {
@@ -156,22 +141,22 @@ const Elf64_Off ProgramHeader::GetAdditionalMemory() const
     return SizeInMemory() - FileSize();
 }
 
-Elf64_Off ProgramHeader::CalculateFileSize(const SECTION_ARRAY& sections) const {
+Elf64_Off ProgramHeader::CalculateFileSize(
+                    const SECTION_ARRAY& sections,
+                    const vector<size_t>& contained) const
+{
 	Elf64_Off size = 0;
 
-	for ( const Section* section : sections )
+	for ( size_t i : contained )
 	{
-        if ( DataStart() <= section->DataStart() &&
-             DataEnd() >= section->DataEnd() )
+        const Section* section = sections[i];
+        if ( section->HasFileData() )
         {
-        	if ( section->HasFileData() )
-        	{
-                Elf64_Off sectionEnd = section->DataEnd() - DataStart();
-                if (sectionEnd > size)
-                {
-                    size = sectionEnd;
-                }
-        	}
+            Elf64_Off sectionEnd = section->DataEnd() - DataStart();
+            if (sectionEnd > size)
+            {
+                size = sectionEnd;
+            }
         }
 	}
 
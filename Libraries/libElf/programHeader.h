@@ -3,13 +3,14 @@
 
 #include <string>
 #include <vector>
-#include "flags.h"
+#include "flagSet.h"
 #include "elf.h"
 using namespace std;
 
 
 class Section;
 class BinaryReader;
+class AddressIndex;
 
 class RawProgramHeader: public Elf64_Phdr {
 public:
@@ -63,6 +64,18 @@ public:
     int FileRank() const;
 };
 
+/*
+ * Segment permissions, as LINK writes them
+ */
+struct SegmentFlagTraits {
+    static constexpr FlagDescriptor descriptors[] = {
+        { 'X', "Executable" },
+        { 'W', "Writeable" },
+        { 'R', "Readable" }
+    };
+};
+typedef FlagSet<SegmentFlagTraits> SegmentFlags;
+
 class ProgramHeader: protected RawProgramHeader {
 public:
     typedef std::vector<Section*> SECTION_ARRAY;
@@ -72,6 +85,14 @@ public:
      */
     ProgramHeader ( BinaryReader&, const SECTION_ARRAY&);
 
+    /**
+     * C'tor, finding our sections through an index over sections, which
+     * can be shared by all the headers in a file
+     */
+    ProgramHeader ( BinaryReader&,
+                    const SECTION_ARRAY&,
+                    const AddressIndex& index);
+
     /**
      * Handle moved binary readers...by redirecting to the std c'tor
      */
@@ -128,18 +149,22 @@ protected:
     /*
      * Calculate size in file, by looking at the size taken up by all sections
      * within the file..
+     *
+     * @param contained  Indexes of the sections within our part of the file
      */
-    Elf64_Off CalculateFileSize(const SECTION_ARRAY& sections) const;
-
-    static const Flags& TypeFlags();
+    Elf64_Off CalculateFileSize( const SECTION_ARRAY& sections,
+                                 const vector<size_t>& contained) const;
 
-    static Flags::Mask Flags_Executable;
-    static Flags::Mask Flags_Writeable;
-    static Flags::Mask Flags_Readable;
+    static constexpr SegmentFlags::Mask Flags_Executable = 
+        SegmentFlags::Letter('X');
+    static constexpr SegmentFlags::Mask Flags_Writeable = 
+        SegmentFlags::Letter('W');
+    static constexpr SegmentFlags::Mask Flags_Readable = 
+        SegmentFlags::Letter('R');
 
 private:
     std::vector<string> sectionNames;
-    Flags flags;
+    SegmentFlags flags;
 };
 
 
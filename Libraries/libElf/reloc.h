@@ -1,9 +1,117 @@
 #ifndef RELOCATION_H
    #define RELOCATION_H
-#include "flags.h"
+#include "flagSet.h"
 #include "elf.h"
 class BinaryReader;
 
+/*
+ * How a relocation is applied, as LINK writes it. 'A' is used twice, so
+ * the masks are taken by position rather than by letter.
+ */
+struct RelocationFlagTraits {
+    enum Position {
+        WRITE, ALLOC, EXECINSTR, ABSOLUTE, RELATIVE, SYMBOL,
+        BYTES_1, BYTES_2, BYTES_4, BYTES_8, 
+        HAS_ADDENDUM, ZERO_EXTENDED, SIGN_EXTENDED
+    };
+    static constexpr FlagDescriptor descriptors[] = {
+        { 'W', "SHF_WRITE" },
+        { 'A', "SHF_ALLOC" },
+        { 'C', "SHF_EXECINSTR" },
+        { 'A', "Absolute" },
+        { 'R', "Relative" },
+        { 'S', "Symbol" },
+        { '1', "1Byte" },
+        { '2', "2Byte" },
+        { '4', "4Byte" },
+        { '8', "8Byte" },
+        { '+', "HasAddendum" },
+        { 'Z', "ZeroExtended" },
+        { 'I', "SignExtended" }
+    };
+};
+typedef FlagSet<RelocationFlagTraits> RelocationFlags;
+
+/*
+ * What we know about an x86-64 relocation type
+ */
+struct RelocationKind {
+    enum Support { 
+        SUPPORTED,
+        // Dynamic linking types (GOT, PLT etc): we know what they are,
+        // but can't handle them
+        UNSUPPORTED,
+        UNKNOWN
+    };
+    enum Extension { NOT_EXTENDED, ZERO_EXTENDED, SIGN_EXTENDED };
+
+    Elf64_Xword type;
+    const char* name;
+    Support support;
+    unsigned char width;  // Bytes patched
+    bool pcRelative;
+    Extension extension;
+};
+
+/*
+ * Every relocation type we know about, indexed by type
+ */
+struct X86RelocationTable {
+    static constexpr RelocationKind kinds[] = {
+        { R_X86_64_NONE,      "R_X86_64_NONE",      RelocationKind::UNSUPPORTED,
+          0, false, RelocationKind::NOT_EXTENDED },
+        { R_X86_64_64,        "R_X86_64_64",        RelocationKind::SUPPORTED, 
+          8, false, RelocationKind::NOT_EXTENDED },
+        // An offset from the instruction pointer
+        { R_X86_64_PC32,      "R_X86_64_PC32",      RelocationKind::SUPPORTED, 
+          4, true,  RelocationKind::NOT_EXTENDED },
+        { R_X86_64_GOT32,     "R_X86_64_GOT32",     RelocationKind::UNSUPPORTED,
+          4, false, RelocationKind::NOT_EXTENDED },
+        { R_X86_64_PLT32,     "R_X86_64_PLT32",     RelocationKind::UNSUPPORTED,
+          4, true,  RelocationKind::NOT_EXTENDED },
+        { R_X86_64_COPY,      "R_X86_64_COPY",      RelocationKind::UNSUPPORTED,
+          0, false, RelocationKind::NOT_EXTENDED },
+        { R_X86_64_GLOB_DAT,  "R_X86_64_GLOB_DAT",  RelocationKind::UNSUPPORTED,
+          8, false, RelocationKind::NOT_EXTENDED },
+        { R_X86_64_JUMP_SLOT, "R_X86_64_JUMP_SLOT", RelocationKind::UNSUPPORTED,
+          8, false, RelocationKind::NOT_EXTENDED },
+        { R_X86_64_RELATIVE,  "R_X86_64_RELATIVE",  RelocationKind::UNSUPPORTED,
+          8, false, RelocationKind::NOT_EXTENDED },
+        { R_X86_64_GOTPCREL,  "R_X86_64_GOTPCREL",  RelocationKind::UNSUPPORTED,
+          4, true,  RelocationKind::NOT_EXTENDED },
+        // Loaded into a register and zero extended into a virtual address
+        { R_X86_64_32,        "R_X86_64_32",        RelocationKind::SUPPORTED, 
+          4, false, RelocationKind::ZERO_EXTENDED },
+        // Loaded into a register and sign extended into a virtual address
+        { R_X86_64_32S,       "R_X86_64_32S",       RelocationKind::SUPPORTED, 
+          4, false, RelocationKind::SIGN_EXTENDED },
+        { R_X86_64_16,        "R_X86_64_16",        RelocationKind::SUPPORTED, 
+          2, false, RelocationKind::ZERO_EXTENDED },
+        { R_X86_64_PC16,      "R_X86_64_PC16",      RelocationKind::SUPPORTED, 
+          2, true,  RelocationKind::SIGN_EXTENDED },
+        { R_X86_64_8,         "R_X86_64_8",         RelocationKind::SUPPORTED, 
+          1, false, RelocationKind::SIGN_EXTENDED },
+        { R_X86_64_PC8,       "R_X86_64_PC8",       RelocationKind::SUPPORTED, 
+          1, true,  RelocationKind::SIGN_EXTENDED }
+    };
+    static constexpr size_t COUNT = sizeof(kinds) / sizeof(RelocationKind);
+
+    // Anything past the end of the table
+    static constexpr RelocationKind unknown = {
+        0, "UNKNOWN", RelocationKind::UNKNOWN,
+        0, false, RelocationKind::NOT_EXTENDED 
+    };
+
+    static constexpr const RelocationKind& Find(Elf64_Xword type) {
+        return type < COUNT ? kinds[type] : unknown;
+    }
+
+    // Entry i must describe type i
+    static constexpr bool InOrder(size_t i = 0) {
+        return i >= COUNT || ( kinds[i].type == i && InOrder(i + 1) );
+    }
+};
+
 class Relocation {
 public:
     Relocation ( const BinaryReader& reader, 
@@ -14,8 +122,8 @@ public:
     
 
     // Calculated properties
-    size_t Size() { return sizeof(Elf64_Rel); }
-    string LinkFormat();
+    size_t Size() { return sizeof(Elf64_Rela); }
+    Elf64_Sxword Addend() { return reloc.r_addend; }
     Elf64_Xword SymbolIndex() { 
         return ELF64_R_SYM(reloc.r_info);
     }
@@ -23,32 +131,83 @@ public:
         return ELF64_R_TYPE(reloc.r_info);
     }
 
+    /*
+     * Work out how to apply the relocation from its type. Anything but
+     * SUPPORTED leaves the flags empty.
+     */
+    RelocationKind::Support Decode();
+
+    // As Decode, but throws a string if the type can't be handled
+    void ConvertFromElf();
+
+    // What we know about our type: valid once decoded
+    const RelocationKind& Kind() const { return *kind; }
+    const char* TypeName() const { return kind->name; }
+    const RelocationFlags& Flags() const { return type; }
+
+    /*
+     * A relocation in LINK format: "loc seg ref type [addend]", where seg
+     * and ref are the LINK numbers (counting from 1) of the segment being
+     * patched and the symbol referred to. The addend is in decimal, and
+     * only written if it isn't 0. Types we can't handle are written as
+     * their ELF name and number, e.g. R_X86_64_PLT32(4), rather than as
+     * flags.
+     */
+    static string LinkFormat( const Elf64_Rela& rela,
+                              Elf64_Word segment,
+                              Elf64_Word symbol);
+
+    // The flags for a kind of relocation
+    static constexpr RelocationFlags::Mask FlagsFor(const RelocationKind& k) {
+        return k.support != RelocationKind::SUPPORTED ? 0 :
+               Flags_Symbol |
+               (k.pcRelative ? Flags_Relative : Flags_Absolute) |
+               (k.width == 1 ? Flags_1Byte :
+                k.width == 2 ? Flags_2Byte :
+                k.width == 4 ? Flags_4Byte : Flags_8Byte) |
+               (k.extension == RelocationKind::ZERO_EXTENDED ? 
+                    Flags_ZeroExtended : 0) |
+               (k.extension == RelocationKind::SIGN_EXTENDED ? 
+                    Flags_SignExtended : 0);
+    }
+
 protected:
-    static const Flags& TypeFlags();
-
-    static Flags::Mask Flags_SHF_WRITE;
-    static Flags::Mask Flags_SHF_ALLOC;
-    static Flags::Mask Flags_SHF_EXECINSTR;
-    static Flags::Mask Flags_Absolute;
-    static Flags::Mask Flags_Relative;
-    static Flags::Mask Flags_Symbol;
-    static Flags::Mask Flags_1Byte;
-    static Flags::Mask Flags_2Byte;
-    static Flags::Mask Flags_4Byte;
-    static Flags::Mask Flags_8Byte;
-    static Flags::Mask Flags_HasAddendum;
-    static Flags::Mask Flags_ZeroExtended;
-    static Flags::Mask Flags_SignExtended;
+    typedef RelocationFlagTraits Traits;
+    static constexpr RelocationFlags::Mask Flags_SHF_WRITE = 
+        RelocationFlags::Bit(Traits::WRITE);
+    static constexpr RelocationFlags::Mask Flags_SHF_ALLOC = 
+        RelocationFlags::Bit(Traits::ALLOC);
+    static constexpr RelocationFlags::Mask Flags_SHF_EXECINSTR = 
+        RelocationFlags::Bit(Traits::EXECINSTR);
+    static constexpr RelocationFlags::Mask Flags_Absolute = 
+        RelocationFlags::Bit(Traits::ABSOLUTE);
+    static constexpr RelocationFlags::Mask Flags_Relative = 
+        RelocationFlags::Bit(Traits::RELATIVE);
+    static constexpr RelocationFlags::Mask Flags_Symbol = 
+        RelocationFlags::Bit(Traits::SYMBOL);
+    static constexpr RelocationFlags::Mask Flags_1Byte = 
+        RelocationFlags::Bit(Traits::BYTES_1);
+    static constexpr RelocationFlags::Mask Flags_2Byte = 
+        RelocationFlags::Bit(Traits::BYTES_2);
+    static constexpr RelocationFlags::Mask Flags_4Byte = 
+        RelocationFlags::Bit(Traits::BYTES_4);
+    static constexpr RelocationFlags::Mask Flags_8Byte = 
+        RelocationFlags::Bit(Traits::BYTES_8);
+    static constexpr RelocationFlags::Mask Flags_HasAddendum = 
+        RelocationFlags::Bit(Traits::HAS_ADDENDUM);
+    static constexpr RelocationFlags::Mask Flags_ZeroExtended = 
+        RelocationFlags::Bit(Traits::ZERO_EXTENDED);
+    static constexpr RelocationFlags::Mask Flags_SignExtended = 
+        RelocationFlags::Bit(Traits::SIGN_EXTENDED);
 
 private:
     // helper functions
     void ConfigureFlags();
-    void ConvertFromElf();
     // data
     string section;
-    Elf64_Rel reloc;
-    Flags type;
-    string x86_type;
+    Elf64_Rela reloc;
+    RelocationFlags type;
+    const RelocationKind* kind;
     short size;
 };
 #endif
@@ -0,0 +1,93 @@
+#include "relocationStore.h"
+#include <algorithm>
+
+RelocationStore::RelocationStore(): symbolsIndexed(false) {
+}
+
+void RelocationStore::Add( const BinaryReader& table,
+                           size_t count,
+                           Elf64_Word target)
+{
+    if ( count == 0 ) {
+        return;
+    }
+    if ( groups.size() > 0 && groups.back().target > target ) {
+        throw string("RelocationStore: Sections added out of order");
+    }
+
+    size_t start = entries.size();
+    entries.resize(start + count);
+    table.Read(&entries[start], count * sizeof(Elf64_Rela));
+
+    // Two tables for the same section share a group
+    if ( groups.size() > 0 && groups.back().target == target ) {
+        groups.back().end = entries.size();
+    } else {
+        Group group = { target, start, entries.size() };
+        groups.push_back(group);
+    }
+    symbolsIndexed = false;
+}
+
+RelocationStore::Range RelocationStore::EntriesAt(size_t group) const {
+    const Elf64_Rela* base = entries.data();
+    Range range = { base + groups[group].begin, base + groups[group].end };
+    return range;
+}
+
+RelocationStore::Range RelocationStore::ForSection(Elf64_Word section) const {
+    auto it = lower_bound(groups.begin(), groups.end(), section,
+        [] (const Group& g, Elf64_Word s) { return g.target < s; });
+    if ( it == groups.end() || it->target != section ) {
+        Range empty = { NULL, NULL };
+        return empty;
+    }
+    return EntriesAt(it - groups.begin());
+}
+
+Elf64_Word RelocationStore::TargetSection(size_t i) const {
+    auto it = upper_bound(groups.begin(), groups.end(), i,
+        [] (size_t idx, const Group& g) { return idx < g.end; });
+    return it->target;
+}
+
+RelocationStore::SymbolRange
+    RelocationStore::ForSymbol(Elf64_Xword symbol) const
+{
+    if ( !symbolsIndexed ) {
+        IndexSymbols();
+    }
+    SymbolRange range = { NULL, NULL };
+    if ( symbol + 1 < symbolStarts.size() ) {
+        const uint32_t* base = symbolOrder.data();
+        range.begin = base + symbolStarts[symbol];
+        range.end = base + symbolStarts[symbol + 1];
+    }
+    return range;
+}
+
+/*
+ * A counting sort of the entries by symbol: two passes over the store,
+ * and no per-symbol allocations
+ */
+void RelocationStore::IndexSymbols() const {
+    Elf64_Xword maxSymbol = 0;
+    for ( const Elf64_Rela& rela: entries ) {
+        maxSymbol = max<Elf64_Xword>(maxSymbol, ELF64_R_SYM(rela.r_info));
+    }
+
+    symbolStarts.assign(entries.size() ? maxSymbol + 2 : 0, 0);
+    for ( const Elf64_Rela& rela: entries ) {
+        ++symbolStarts[ELF64_R_SYM(rela.r_info) + 1];
+    }
+    for ( size_t s = 1; s < symbolStarts.size(); ++s ) {
+        symbolStarts[s] += symbolStarts[s-1];
+    }
+
+    symbolOrder.resize(entries.size());
+    vector<uint32_t> next(symbolStarts);
+    for ( size_t i = 0; i < entries.size(); ++i ) {
+        symbolOrder[next[ELF64_R_SYM(entries[i].r_info)]++] = i;
+    }
+    symbolsIndexed = true;
+}
@@ -0,0 +1,89 @@
+#ifndef RELOCATION_STORE_H
+#define RELOCATION_STORE_H
+#include <elf.h>
+#include <vector>
+#include <cstdint>
+#include "binaryReader.h"
+
+using namespace std;
+
+/**
+    \class   RelocationStore
+    \brief   Every relocation in a file, in one contiguous array
+    \details The raw Elf64_Rela entries of all the SHT_RELA sections are
+             copied into a single array, grouped by the section they
+             apply to (in ascending section index). No per-relocation
+             objects are built: use Relocation::LinkFormat or
+             X86RelocationTable to interpret an entry.
+
+             The relocations against each symbol are found through an
+             index that is built the first time it is asked for.
+*/
+class RelocationStore {
+public:
+    /*
+     * [begin, end) of the entries in a group
+     */
+    struct Range {
+        const Elf64_Rela* begin;
+        const Elf64_Rela* end;
+
+        const Elf64_Rela* Begin() const { return begin; }
+        const Elf64_Rela* End() const { return end; }
+        size_t Size() const { return end - begin; }
+    };
+
+    RelocationStore();
+
+    /*
+     * Add count entries read from table, which apply to section target.
+     * Sections must be added in ascending order of target.
+     */
+    void Add(const BinaryReader& table, size_t count, Elf64_Word target);
+
+    size_t Size() const { return entries.size(); }
+    const Elf64_Rela& operator[](size_t i) const { return entries[i]; }
+
+    // The sections that have relocations, in ascending order
+    size_t Sections() const { return groups.size(); }
+    Elf64_Word SectionAt(size_t group) const { return groups[group].target; }
+    Range EntriesAt(size_t group) const;
+
+    // The relocations that apply to section (empty if there are none)
+    Range ForSection(Elf64_Word section) const;
+
+    // The section that entry i applies to
+    Elf64_Word TargetSection(size_t i) const;
+
+    /*
+     * Indexes (into this store) of the relocations against symbol, in
+     * store order.
+     */
+    struct SymbolRange {
+        const uint32_t* begin;
+        const uint32_t* end;
+
+        const uint32_t* Begin() const { return begin; }
+        const uint32_t* End() const { return end; }
+        size_t Size() const { return end - begin; }
+    };
+    SymbolRange ForSymbol(Elf64_Xword symbol) const;
+
+private:
+    void IndexSymbols() const;
+
+    struct Group {
+        Elf64_Word target;
+        size_t begin;
+        size_t end;
+    };
+
+    vector<Elf64_Rela> entries;
+    vector<Group> groups;
+
+    // By symbol index: symbolOrder[symbolStarts[s], symbolStarts[s+1])
+    mutable vector<uint32_t> symbolStarts;
+    mutable vector<uint32_t> symbolOrder;
+    mutable bool symbolsIndexed;
+};
+#endif
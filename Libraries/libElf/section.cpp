@@ -3,68 +3,68 @@
 #endif
 #include <sstream>
 #include "stringTable.h"
+#include "stringBlock.h"
 #include "binaryReader.h"
 #include "dataVector.h"
 #include "binaryData.h"
 #include <memory>
 
 Section::Section( ) 
-    :  data(NULL), 
-       stringTable(NULL), 
-       sh_flags(TypeFlags())
+    :  viewSize(0),
+       sourceOffset(0),
+       data(NULL), 
+       stringTable(NULL)
 {
 }
 
 Section::Section( const BinaryReader& headerPos, 
                   const BinaryReader& strings ) 
-    : SectionHeader(headerPos), sh_flags(TypeFlags())
+    : SectionHeader(headerPos)
 {
     // Get our name
-    name = (strings + (long)NameOffset()).ReadString();
+    ownedName = (strings + (long)NameOffset()).ReadString();
+    name = ownedName;
 
-    // Get our data
-    data = shared_ptr<Data>(
-               new Data( headerPos.Begin() + DataStart(), 
-                         DataSize()));
+    // Don't copy our data out of the file until someone wants to change
+    // it: until then we just remember where it is
+    view = unique_ptr<BinaryReader>(
+               new BinaryReader(headerPos.Begin() + DataStart()));
+    // SHT_NOBITS sections take no space in the file: there's nothing to read
+    viewSize = HasFileData() ? DataSize() : 0;
+    sourceOffset = DataStart();
 
     SetFlags();
 }
 
-Flags::Mask Section::Flags_SHF_WRITE  = Flags::EmptyMask;
-Flags::Mask Section::Flags_SHF_ALLOC  = Flags::EmptyMask;
-Flags::Mask Section::Flags_SHF_EXECINSTR  = Flags::EmptyMask;
-
-const Flags& Section::TypeFlags() {
-    static unique_ptr<Flags> flags = NULL;
+Section::Section( const BinaryReader& headerPos, 
+                  const StringBlock& names ) 
+    : SectionHeader(headerPos)
+{
+    name = names.At(NameOffset());
 
-    if ( !flags) {
-        flags = unique_ptr<Flags>(new Flags(""));
+    view = unique_ptr<BinaryReader>(
+               new BinaryReader(headerPos.Begin() + DataStart()));
+    viewSize = HasFileData() ? DataSize() : 0;
+    sourceOffset = DataStart();
 
-        Flags_SHF_WRITE = 
-            flags->AddFlag('W', "SHF_WRITE");
-        Flags_SHF_ALLOC = 
-            flags->AddFlag('A', "SHF_ALLOC");
-        Flags_SHF_EXECINSTR = 
-            flags->AddFlag('C', "SHF_EXECINSTR");
-    }
-    return *flags;
+    SetFlags();
 }
 
+constexpr FlagDescriptor SectionFlagTraits::descriptors[];
+
 void Section::SetFlags() {
-    if ( Writeable() ) 
-        sh_flags.SetFlags(Flags_SHF_WRITE,true);
-    if ( Allocate() ) 
-        sh_flags.SetFlags(Flags_SHF_ALLOC,true);
-    if ( Executable() ) 
-        sh_flags.SetFlags(Flags_SHF_EXECINSTR,true);
+    sh_flags = SectionFlags(RawFlags() & ( Flags_SHF_WRITE | 
+                                           Flags_SHF_ALLOC |
+                                           Flags_SHF_EXECINSTR ));
 }
 
 Section::~Section () {
 }
 
 Section::Section(string header, StringTable * stable)
-    : data(NULL),
-    sh_flags(TypeFlags()) 
+    : viewSize(0),
+    sourceOffset(0),
+    data(NULL)
 {
     this->stringTable = stable;
 
@@ -75,14 +75,15 @@ Section::Section(string header, StringTable * stable)
     Elf64_Xword size;
     Elf64_Xword align;
 
-    s >> name;
+    s >> ownedName;
+    name = ownedName;
     s >> hex >> addr;
     s >> hex >> size;
     s >> flags;
-    sh_flags.SetFlags(flags);
+    sh_flags.SetLetters(flags);
     s >> align;
 
-    NameOffset() = stringTable->AddString(name.c_str());
+    NameOffset() = stringTable->AddString(ownedName);
     RawType() = SHT_PROGBITS; // sym tables etc may override
     RawFlags() = GetFlags();
     Address() = addr;
@@ -100,13 +101,12 @@ Section::Section(string header, StringTable * stable)
 
 
 Elf64_Xword Section::GetFlags() {
-    // As it happens, the internal mask of our Flags object is
-    // exactly this, but this safe guards against a change in elf.h
-    Elf64_Xword result = 0;
-    if ( sh_flags["SHF_WRITE"] ) result |= SHF_WRITE;
-    if ( sh_flags["SHF_ALLOC"] ) result |= SHF_ALLOC;
-    if ( sh_flags["SHF_EXECINSTR"] ) result |= SHF_EXECINSTR;
-    return result;
+    // Our flags are laid out exactly as ELF's (see SetFlags)
+    static_assert( Flags_SHF_WRITE == SHF_WRITE &&
+                   Flags_SHF_ALLOC == SHF_ALLOC &&
+                   Flags_SHF_EXECINSTR == SHF_EXECINSTR,
+                   "Section flags don't match elf.h");
+    return sh_flags.Raw();
 }
 
 // Expected format: "name value segmentIndex type scope"
@@ -124,7 +124,12 @@ string Section::WriteLinkHeader() {
 string Section::WriteLinkData() {
     ostringstream linkdata;
     linkdata << "# Data for section " << name << endl;
-    linkdata << data->HexCode() ;
+    if ( IsView() ) {
+        // Only hold a copy of the data long enough to print it
+        linkdata << Data(*view, viewSize).HexCode();
+    } else if ( data ) {
+        linkdata << data->HexCode() ;
+    }
     return linkdata.str();
 }
 
@@ -139,7 +144,7 @@ string Section::GetLinkFlags() {
 
 bool Section::IsLInkSection() {
     return not (IsSymTable() || IsStringTable() || IsRelocTable() 
-                || name == "");
+                || name.Empty());
 
 }
 
@@ -149,15 +154,16 @@ Section * Section::MakeNewStringTable( StringTable &tab, StringTable* sectionNam
     Section * newSection = new Section();
 
     // Set up the name, and string table refs
-    newSection->name = name;
+    newSection->ownedName = name;
+    newSection->name = newSection->ownedName;
     newSection->stringTable = sectionNames;
-    newSection->NameOffset() = sectionNames->AddString(name.c_str());
+    newSection->NameOffset() = sectionNames->AddString(name);
 
     //
     // set up the various constant flags
     //
       
-    newSection->sh_flags.SetFlags(Flags_SHF_WRITE); // Only writeable
+    newSection->sh_flags = SectionFlags(Flags_SHF_WRITE); // Only writeable
 
     newSection->ItemSize() = 0; //no fixed sized entries
 
@@ -175,11 +181,51 @@ Section * Section::MakeNewStringTable( StringTable &tab, StringTable* sectionNam
     tab.WriteTable(newSection->data->Writer());
     newSection->DataSize() = newSection->data->Size();
 
+    // Now the table is laid out we can find where our name was placed
+    newSection->NameOffset() = sectionNames->Offset(newSection->NameOffset());
 
     // caller must delete
     return newSection;
 }
 
+shared_ptr<Data> Section::GetData() {
+    if ( IsView() ) {
+        // Copy on write: take a private copy of the file data
+        data = shared_ptr<Data>(new Data(*view, viewSize));
+        view.reset();
+    }
+    return data;
+}
+
 void Section::WriteRawData(BinaryWriter &writer) const {
-    writer.Write(data->Reader(),data->Size());
+    if ( IsView() ) {
+        writer.Write(*view, viewSize);
+    } else if ( data ) {
+        writer.Write(data->Reader(),data->Size());
+    }
+}
+
+void Section::WriteRawData(BinaryWriter &writer, long offset, long size) const {
+    if ( IsView() ) {
+        writer.Write(*view + offset, size);
+    } else if ( data ) {
+        writer.Write(data->Reader() + offset, size);
+    }
+}
+
+void Section::ReadRawData(long offset, void* dest, long size) const {
+    if ( IsView() ) {
+        (*view + offset).Read(dest, size);
+    } else if ( data ) {
+        (data->Reader() + offset).Read(dest, size);
+    }
+}
+
+Elf64_Xword Section::RawDataSize() const {
+    if ( IsView() ) {
+        return viewSize;
+    } else if ( data ) {
+        return data->Size();
+    }
+    return 0;
 }
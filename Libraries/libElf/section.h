@@ -2,21 +2,39 @@
 #define SectionX86_64
 #include <string>
 #include <vector>
-#include "flags.h"
+#include "flagSet.h"
 #include "elf.h"
 #include "binaryData.h"
 #include "sectionHeader.h"
+#include "nameView.h"
 #include <memory>
 
 class StringTable;
+class StringBlock;
 class BinaryReader;
 using namespace std;
 
+/*
+ * The section flags LINK knows about. The order of the table is the order
+ * the letters are written in.
+ */
+struct SectionFlagTraits {
+    static constexpr FlagDescriptor descriptors[] = {
+        { 'W', "SHF_WRITE" },
+        { 'A', "SHF_ALLOC" },
+        { 'C', "SHF_EXECINSTR" }
+    };
+};
+typedef FlagSet<SectionFlagTraits> SectionFlags;
+
 class Section: public SectionHeader{
     friend class X86Parser;
 public:
     Section( const BinaryReader& headerPos, 
              const BinaryReader &strings );
+    // Name is a view into names, which must outlive the section
+    Section( const BinaryReader& headerPos, 
+             const StringBlock &names );
     Section (string header, StringTable* );
     ~Section ();
     Elf64_Xword GetFlags() ;
@@ -31,10 +49,41 @@ public:
         WriteRawData(writer);
     }
 
+    /*
+     * Copy size bytes of the section's data, starting offset bytes in, to
+     * writer or dest. RawDataSize is the number of bytes WriteRawData
+     * would write.
+     */
+    void WriteRawData(BinaryWriter &writer, long offset, long size) const;
+    void ReadRawData(long offset, void* dest, long size) const;
+    Elf64_Xword RawDataSize() const;
+
     bool IsLInkSection();
-    string Name() { return name; }
+    string Name() { return name.ToString(); }
+    NameView NameRef() const { return name; }
 
-    shared_ptr<Data> GetData() { return data; }
+    /**
+     * Mutable access to the section's bytes.
+     *
+     * Sections read from a file start life as a view into the input
+     * (see IsView), the first call to GetData copies the bytes into a
+     * private Data object which the caller is then free to re-size and
+     * re-write.
+     */
+    shared_ptr<Data> GetData();
+
+    /**
+     * True if the section's bytes are still read straight from the input
+     * file, rather than from a private copy.
+     */
+    bool IsView() const { return view.get() != NULL; }
+
+    /**
+     * Where the section's bytes started in the input file. Unlike
+     * DataStart, this isn't changed when the section is placed in an
+     * output file.
+     */
+    Elf64_Off SourceOffset() const { return sourceOffset; }
 
     // The caller is repsonsible for destruction
     static Section* MakeNewStringTable( StringTable &tab, StringTable *sectionNames, string name);
@@ -42,17 +91,28 @@ public:
 
 
 protected:
-    static const Flags& TypeFlags();
     void SetFlags();
-    static Flags::Mask Flags_SHF_WRITE;
-    static Flags::Mask Flags_SHF_ALLOC;
-    static Flags::Mask Flags_SHF_EXECINSTR;
+    static constexpr SectionFlags::Mask Flags_SHF_WRITE = 
+        SectionFlags::Letter('W');
+    static constexpr SectionFlags::Mask Flags_SHF_ALLOC = 
+        SectionFlags::Letter('A');
+    static constexpr SectionFlags::Mask Flags_SHF_EXECINSTR = 
+        SectionFlags::Letter('C');
 private:
     Section ();
+
+    // Non-owning view of our bytes in the input file. Only valid until
+    // the data is materialised by GetData(), after which it is released.
+    unique_ptr<BinaryReader> view;
+    Elf64_Xword viewSize;
+    Elf64_Off sourceOffset;
+
     shared_ptr<Data> data;
     StringTable *stringTable;
-    string name;
-    Flags sh_flags;
+    // Read from a string table, or ownedName for synthesised sections
+    NameView name;
+    string ownedName;
+    SectionFlags sh_flags;
     /* data */
 };
 
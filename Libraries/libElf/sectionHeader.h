@@ -20,6 +20,10 @@ public:
     inline bool IsStringTable() const {return sh_type ==  SHT_STRTAB; }
     inline bool IsRelocTable() const {return sh_type ==  SHT_RELA; }
     inline bool IsNull() const { return sh_type == SHT_NULL; }
+    // For relocation tables: the section the relocations apply to
+    inline Elf64_Word RelocTarget() const { return sh_info; }
+    // ...and the symbol table their symbol indexes refer to
+    inline Elf64_Word RelocSymbols() const { return sh_link; }
     inline Elf64_Xword& Alignment() { return sh_addralign; }
     
     // Data properties
@@ -0,0 +1,231 @@
+#include "streamReader.h"
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Smallest read to make from the stream: we want to avoid a system call
+ * per symbol
+ */
+static const long READ_CHUNK = 64 * 1024;
+
+StreamReader::StreamReader(int f, long windowLimit) 
+    : fd(f), 
+      limit(windowLimit),
+      windowStart(0),
+      streamPos(0),
+      atEnd(false),
+      peakWindow(0),
+      scan(ByteScan::Best())
+{
+}
+
+void StreamReader::Fill(long end) const {
+    if ( end - windowStart > limit ) {
+        ostringstream err;
+        err << "StreamReader: Reading to " << end << " would need a window of ";
+        err << (end - windowStart) << " bytes, but the limit is " << limit;
+        throw err.str();
+    }
+
+    while ( streamPos < end && !atEnd ) {
+        // Skip over anything that was released before we got to it
+        long skip = windowStart - streamPos;
+        long want = max(READ_CHUNK, end - streamPos);
+
+        // Don't read ahead past the limit
+        if ( skip <= 0 ) {
+            want = min(want, limit - (streamPos - windowStart));
+        }
+
+        size_t used = window.size();
+        window.resize(used + want);
+        ssize_t got = read(fd, &window[used], want);
+        if ( got < 0 && errno == EINTR ) {
+            window.resize(used);
+            continue;
+        } else if ( got < 0 ) {
+            window.resize(used);
+            throw string("StreamReader: Failed to read: ") + strerror(errno);
+        } else if ( got == 0 ) {
+            atEnd = true;
+        }
+        window.resize(used + got);
+        streamPos += got;
+
+        if ( skip > 0 ) {
+            window.erase(window.begin(), 
+                         window.begin() + min<long>(skip, window.size()));
+        }
+    }
+
+    if ( (long)window.size() > peakWindow ) {
+        peakWindow = window.size();
+    }
+}
+
+const char* StreamReader::Locate(long offset, 
+                                 long end, 
+                                 long& blockStart, 
+                                 long& blockEnd) const
+{
+    // Retained copies first: the window may have moved on
+    auto it = retained.upper_bound(offset);
+    if ( it != retained.begin() ) {
+        --it;
+        long start = it->first;
+        long stop = start + it->second.size();
+        if ( offset >= start && end <= stop ) {
+            blockStart = start;
+            blockEnd = stop;
+            return it->second.data() + (offset - start);
+        }
+    }
+
+    if ( offset < windowStart ) {
+        ostringstream err;
+        err << "StreamReader: Offset " << offset << " has already been released";
+        err << " (window starts at " << windowStart << ")";
+        throw err.str();
+    }
+
+    if ( end > streamPos ) {
+        Fill(end);
+    }
+
+    if ( end > streamPos ) {
+        ostringstream err;
+        err << "StreamReader: Read to " << end << " is past the end of the ";
+        err << "stream (" << streamPos << " bytes)";
+        throw err.str();
+    }
+
+    blockStart = windowStart;
+    blockEnd = streamPos;
+    return window.data() + (offset - windowStart);
+}
+
+void StreamReader::Read(long offset, void *dest, long size) const {
+    long blockStart, blockEnd;
+    const char* src = Locate(offset, offset + size, blockStart, blockEnd);
+    memcpy(dest, src, size);
+}
+
+unsigned char StreamReader::Get(long offset) const {
+    unsigned char c;
+    Read(offset, &c, 1);
+    return c;
+}
+
+void StreamReader::ReadString(long offset, string& dest) const {
+    long end = Next(offset, '\0');
+    long blockStart, blockEnd;
+    const char* str = Locate(offset, end, blockStart, blockEnd);
+    dest.assign(str, end - offset);
+}
+
+long StreamReader::Size() const {
+    return streamPos;
+}
+
+/*
+ * Searches forward through the block holding offset, reading more of the
+ * stream if we run off the end of the window. Returns Size() if c is not
+ * found before the end of the stream.
+ */
+long StreamReader::Next( long offset, unsigned char c) const {
+    long blockStart, blockEnd;
+    const char* start = Locate(offset, offset, blockStart, blockEnd);
+    const char* stop = start + (blockEnd - offset);
+    const char* found = scan.Find(start, stop, c);
+
+    long pos = offset + (found - start);
+    if ( found == stop ) {
+        if ( blockEnd == streamPos && !atEnd ) {
+            // Ran off the end of the window: keep reading
+            while ( pos == streamPos && !atEnd ) {
+                Fill(streamPos + READ_CHUNK);
+                const char* from = window.data() + (pos - windowStart);
+                const char* to = window.data() + window.size();
+                pos += scan.Find(from, to, c) - from;
+            }
+        } else if ( blockEnd != streamPos ) {
+            ostringstream err;
+            err << "StreamReader: No " << (int)c << " in the retained block ";
+            err << "after " << offset;
+            throw err.str();
+        }
+    }
+    return pos;
+}
+
+/*
+ * Searches back through the block holding offset, stopping before the 
+ * first byte of the file. Returns 0 if c was not found.
+ */
+long StreamReader::Last( long offset, unsigned char c) const {
+    long blockStart, blockEnd;
+    const char* start = Locate(offset, offset + 1, blockStart, blockEnd);
+    long from = max(blockStart, 1L);
+    if ( offset < from ) {
+        return 0;
+    }
+
+    const char* found = scan.FindLast(start - (offset - from), start + 1, c);
+    long pos = 0;
+    if ( found ) {
+        pos = offset - (start - found);
+    } else if ( from > 1 ) {
+        ostringstream err;
+        err << "StreamReader: Search back from " << offset << " ran into ";
+        err << "released data";
+        throw err.str();
+    }
+    return pos;
+}
+
+void StreamReader::Retain(long offset, long size) const {
+    long end = offset + size;
+    if ( end > streamPos ) {
+        Fill(end);
+    }
+    end = min(end, streamPos);
+    if ( end <= offset ) {
+        return;
+    }
+
+    // Already have it?
+    long blockStart, blockEnd;
+    auto it = retained.upper_bound(offset);
+    if ( it != retained.begin() ) {
+        --it;
+        if ( offset >= it->first && end <= it->first + (long)it->second.size() ) {
+            return;
+        }
+    }
+
+    const char* src = Locate(offset, end, blockStart, blockEnd);
+    vector<char>& copy = retained[offset];
+    if ( (long)copy.size() < end - offset ) {
+        copy.assign(src, src + (end - offset));
+    }
+}
+
+void StreamReader::Release(long offset) const {
+    if ( offset <= windowStart ) {
+        return;
+    }
+
+    long drop = min<long>(offset - windowStart, window.size());
+    window.erase(window.begin(), window.begin() + drop);
+    windowStart = offset;
+
+    // Give back the memory if the window is now much smaller than its peak
+    if ( window.capacity() > 2 * window.size() + READ_CHUNK ) {
+        vector<char>(window).swap(window);
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include "binaryReader.h"
+#include "byteScan.h"
+#include <vector>
+#include <map>
+
+using namespace std;
+
+/**
+    \class   StreamReader
+    \brief   Read an ELF file from a pipe, or any other file descriptor 
+             which can only be read front to back.
+    \details Data is read from the descriptor on demand, into a window 
+             which starts at the first byte that may still be needed. 
+             The reader can not go back to data which has left the
+             window, so the user must:
+                - Retain() any range it will need again later, before
+                  moving past it
+                - Release() data it has finished with, so that the window
+                  can slide forward.
+
+             The window is bounded: reading so far ahead that it would
+             have to hold more than the limit throws. Reading data which
+             has already been released throws.
+
+             Since the whole file can't be seen up front, Size() is the
+             number of bytes read so far, until the end of the stream has
+             been reached.
+             
+             Reads (which fill the window) are not thread safe. Reads
+             which only touch retained ranges are.
+*/
+class StreamReader: public FileLikeReader {
+public:
+    static const long DEFAULT_WINDOW_LIMIT = 1024L * 1024L * 1024L;
+
+    /*
+     * Read from fd, which is not closed by the reader
+     */
+    StreamReader (int fd, long windowLimit = DEFAULT_WINDOW_LIMIT);
+    virtual ~StreamReader() {}
+
+    virtual void Read(long offset, void *dest, long size) const;
+    virtual void ReadString(long offset, string& dest) const;
+    virtual unsigned char Get(long offset) const;
+
+    virtual long Size() const;
+    virtual long Next( long offset, unsigned char c) const;
+    virtual long Last( long offset, unsigned char c) const;
+
+    /*
+     * Keep a copy of [offset, offset+size) (or up to the end of the 
+     * stream if that comes first) for the lifetime of the reader
+     */
+    void Retain(long offset, long size) const;
+
+    /*
+     * Nothing before offset, other than retained ranges, will be read
+     * again
+     */
+    void Release(long offset) const;
+
+    // Has the whole stream been read?
+    bool AtEnd() const { return atEnd; }
+
+    // Largest number of (non-retained) bytes held at once
+    long PeakWindow() const { return peakWindow; }
+
+private:
+    /*
+     * Find the contiguous block of data holding offset, reading forward
+     * to include end if it is in the window. Throws if the data isn't
+     * available.
+     */
+    const char* Locate(long offset, long end, long& blockStart, long& blockEnd) const;
+
+    // Read from the stream until the window reaches end, or the stream ends
+    void Fill(long end) const;
+
+    int fd;
+    long limit;
+
+    // [windowStart, streamPos) is in memory, anything before windowStart
+    // has been released
+    mutable vector<char> window;
+    mutable long windowStart;
+    mutable long streamPos;
+    mutable bool atEnd;
+    mutable long peakWindow;
+
+    // Retained copies, by start offset
+    mutable map<long, vector<char> > retained;
+
+    const ByteScan& scan;
+};
+#endif
@@ -0,0 +1,42 @@
+#include "stringBlock.h"
+#include "elfReader.h"
+#include "elfArena.h"
+#include "byteScan.h"
+
+StringBlock::StringBlock(const FileLikeReader& file, 
+                         long offset, 
+                         long length,
+                         ElfArena& arena)
+    : data(""), size(0)
+{
+    // Stay inside the file, whatever the section header says
+    long fileSize = file.Size();
+    if ( offset < 0 || offset > fileSize ) {
+        offset = fileSize;
+    }
+    if ( length > fileSize - offset ) {
+        length = fileSize - offset;
+    }
+
+    if ( length > 0 ) {
+        const ElfFileReader* mapped = dynamic_cast<const ElfFileReader*>(&file);
+        if ( mapped ) {
+            data = mapped->Data() + offset;
+        } else {
+            char* copy = arena.Allocate<char>(length);
+            file.Read(offset, copy, length);
+            data = copy;
+        }
+        size = length;
+    }
+}
+
+NameView StringBlock::At(long offset) const {
+    NameView name;
+    if ( offset >= 0 && offset < size ) {
+        const char* start = data + offset;
+        const char* end = ByteScan::Best().Find(start, data + size, '\0');
+        name = NameView(start, end - start);
+    }
+    return name;
+}
@@ -0,0 +1,37 @@
+#ifndef STRING_BLOCK_H
+#define STRING_BLOCK_H
+#include "nameView.h"
+#include "binaryReader.h"
+
+class ElfArena;
+
+/**
+    \class   StringBlock
+    \brief   An ELF string table in memory, from which names can be taken
+             as NameViews
+    \details If the file is mapped (ElfFileReader) the block is just a 
+             pointer into the mapping. Otherwise the table is copied once, 
+             into the arena, rather than once per name.
+*/
+class StringBlock {
+public:
+    StringBlock(): data(""), size(0) {}
+
+    StringBlock(const FileLikeReader& file, 
+                long offset, 
+                long size,
+                ElfArena& arena);
+
+    /*
+     * The null terminated string at offset. Offsets outside the table
+     * give an empty name.
+     */
+    NameView At(long offset) const;
+
+    long Size() const { return size; }
+
+private:
+    const char* data;
+    long size;
+};
+#endif
@@ -1,46 +1,154 @@
+/*
+* The String table is just a list of null-terminated strings.
+* The first byte, index 0, must hold the null character:
+*    "\0StringOne\0StringTwo\0StringThree\0"
+*
+*/
 #include <cstring>
+#include <algorithm>
 #include "binaryWriter.h"
+#include "stringTable.h"
+#include "byteScan.h"
 
-#ifndef STR_TAB_H
-   #include "stringTable.h"
-#endif
+StringTable::StringTable (Mode m) 
+    : mode(m), mergeValid(false)
+{
+    buffer.reserve(4096);
+    buffer.push_back('\0'); //first byte is defined to hold the null char
+}
 
-StringTable::StringTable () {
-    writePtr=1;//first byte is defined to hold the null char
-    strings.reserve(1000);
+long StringTable::AddString(const char * str) {
+    return AddString(str, strlen(str));
 }
-StringTable::~StringTable ( ) {
-    // Clear out the heap - we know all these are allocated since
-    // we created them
-    for ( auto str: strings ) {
-        delete [] str->str;
-        delete str;
+
+long StringTable::AddString(const char * str, size_t length) {
+    // The empty string is always at the start of the table
+    if ( length == 0 ) {
+        return 0;
     }
+
+    long offset = offsets.Find(str, length);
+    if ( offset == NameIndex::NOT_FOUND ) {
+        offset = buffer.size();
+        buffer.insert(buffer.end(), str, str + length);
+        buffer.push_back('\0');
+        offsets.Set(str, length, offset);
+        mergeValid = false;
+    }
+
+    return offset;
 }
 
-long StringTable::AddString(const char * str) {
-    StringTable::ElfString *string = new StringTable::ElfString;
+long StringTable::Offset(long handle) {
+    if ( mode == APPEND || handle == 0 ) {
+        return handle;
+    }
 
-    // Build the ElfString
-      
-    string->size = strlen(str) + 1; // +1 for null char
-    string->offset = this->writePtr;
-    string->str = new char[string->size];
-    
-    // set the string value
-    memcpy(string->str,str,string->size);
+    MergeTails();
+    auto it = lower_bound(starts.begin(), starts.end(), handle);
+    if ( it == starts.end() || *it != handle ) {
+        throw "StringTable::Offset: Not a valid string handle";
+    }
+    return mergedOffsets[it - starts.begin()];
+}
 
-    strings.insert(strings.end(),string);
-    this->writePtr += string->size;
+long StringTable::Size() {
+    if ( mode == APPEND ) {
+        return buffer.size();
+    }
 
-    return string->offset;
+    MergeTails();
+    return merged.size();
 }
 
 void StringTable::WriteTable(BinaryWriter& writer) {
-    writer.Write("\0",1);
-	writer+=1;
-    for (ElfString* & str : this->strings) {
-        writer.Write(str->str,str->size);
-        writer += str->size;
+    const std::vector<char>* table = &buffer;
+    if ( mode == TAIL_MERGE ) {
+        MergeTails();
+        table = &merged;
+    }
+
+    writer.Write(table->data(), table->size());
+    writer += table->size();
+}
+
+/*
+ * Sort the strings by their reversed text: a string which is the tail of 
+ * another then sorts directly before it (or before a string which shares
+ * the same tail). Walking the sorted list backwards each string is either 
+ * the tail of the one before, and can share its storage, or starts a new
+ * entry in the table.
+ */
+void StringTable::MergeTails() {
+    if ( mergeValid ) {
+        return;
+    }
+
+    // Split the table at each null: each string starts just after the
+    // previous one ends
+    std::vector<long> ends;
+    ends.reserve(offsets.Size() + 1);
+    ByteScan::Best().FindAll(buffer.data(), 
+                             buffer.data() + buffer.size(), 
+                             '\0', 
+                             ends);
+
+    starts.resize(ends.size() - 1);
+    std::vector<size_t> lengths(starts.size());
+    for ( size_t i=0; i < starts.size(); ++i ) {
+        starts[i] = ends[i] + 1;
+        lengths[i] = ends[i+1] - starts[i];
+    }
+
+    // Compare the strings end first
+    const char* text = buffer.data();
+    std::vector<size_t> order(starts.size());
+    for ( size_t i=0; i < order.size(); ++i ) {
+        order[i] = i;
     }
+    std::sort(order.begin(), order.end(), 
+        [&] (size_t lhs, size_t rhs) -> bool {
+            const char* l = text + starts[lhs] + lengths[lhs];
+            const char* r = text + starts[rhs] + lengths[rhs];
+            size_t n = std::min(lengths[lhs], lengths[rhs]);
+            for ( size_t i=1; i <= n; ++i ) {
+                if ( *(l - i) != *(r - i) ) {
+                    return (unsigned char)*(l - i) < (unsigned char)*(r - i);
+                }
+            }
+            if ( lengths[lhs] != lengths[rhs] ) {
+                return lengths[lhs] < lengths[rhs];
+            }
+            return lhs < rhs;
+        });
+
+    merged.clear();
+    merged.reserve(buffer.size());
+    merged.push_back('\0');
+    mergedOffsets.assign(starts.size(), 0);
+
+    size_t prev = 0;
+    for ( size_t i = order.size(); i > 0; --i ) {
+        size_t idx = order[i-1];
+        size_t len = lengths[idx];
+        const char* str = text + starts[idx];
+
+        bool isTail = false;
+        if ( i < order.size() ) {
+            size_t prevLen = lengths[prev];
+            const char* prevEnd = text + starts[prev] + prevLen;
+            isTail = len <= prevLen && 
+                     memcmp(prevEnd - len, str, len) == 0;
+        }
+
+        if ( isTail ) {
+            mergedOffsets[idx] = mergedOffsets[prev] + lengths[prev] - len;
+        } else {
+            mergedOffsets[idx] = merged.size();
+            merged.insert(merged.end(), str, str + len + 1);
+        }
+        prev = idx;
+    }
+
+    mergeValid = true;
 }
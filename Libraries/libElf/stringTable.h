@@ -1,34 +1,74 @@
 #ifndef STR_TAB_H
-   #define STR_TAB_H
-#endif
+#define STR_TAB_H
 #include <vector>
+#include <string>
 #include "section.h"
+#include "nameIndex.h"
+
+/**
+    \class   StringTable
+    \brief   Build the contents of an ELF string table (.strtab, .shstrtab)
+    \details The table is built directly in its output format, in a single
+             growable buffer: 
+                "\0StringOne\0StringTwo\0StringThree\0"
+
+             Each string is only stored once: adding a string that is
+             already in the table returns the offset of the existing copy.
+
+             In TAIL_MERGE mode a string which is the tail of another
+             (".text" and ".rela.text") is not stored separately, but 
+             points into the end of the longer string. Since the layout 
+             can't be known until every string has been added, AddString
+             returns a handle which must be passed to Offset() to find 
+             where the string ended up. Offsets are only final once the
+             last string has been added.
 
+             In the default mode the handle is the offset.
+*/
 class StringTable {
     public:
-        struct ElfString {
-        public: 
-            char * str;
-            long size;
-            long offset;
+        enum Mode {
+            APPEND,
+            TAIL_MERGE
         };
-        
-        StringTable();
-        ~StringTable();
+
+        StringTable(Mode mode = APPEND);
+
+        /*
+         * Add str to the table (if it isn't already there) and return 
+         * its handle
+         */
         long AddString(const char * str);
+        long AddString(const char * str, size_t length);
+        long AddString(const std::string& str) {
+            return AddString(str.c_str(), str.length());
+        }
+        long AddString(const NameView& str) {
+            return AddString(str.Data(), str.Length());
+        }
+
+        // Position of the string in the output table
+        long Offset(long handle);
+
         void WriteTable(BinaryWriter& writer);
         void WriteTable(BinaryWriter&& writer) {
             WriteTable(writer);
         };
-        long Size() { return writePtr;}
+        long Size();
     private:
-        std::vector<ElfString *> strings;
-        long writePtr;
-};
+        void MergeTails();
 
-/*
-* The String table is just a list of null-terminated strings.
-* The first byte, index 0, must hold the null character:
-*    "\0StringOne\0StringTwo\0StringThree\0"
-*
-*/
+        Mode mode;
+
+        // All strings, in the order they were added
+        std::vector<char> buffer;
+        NameIndex offsets;
+
+        // TAIL_MERGE only: the merged table, and where each string in
+        // buffer was placed in it
+        std::vector<char> merged;
+        std::vector<long> starts;
+        std::vector<long> mergedOffsets;
+        bool mergeValid;
+};
+#endif
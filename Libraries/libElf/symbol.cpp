@@ -1,84 +1,53 @@
 #include "symbol.h"
 #include <sstream>
 #include "binaryReader.h"
+#include "stringBlock.h"
 #include <memory>
 using namespace std;
 
 
 Symbol::Symbol ( BinaryReader& reader,
-                 BinaryReader& stable )
-: type(TypeFlags()), scope(ScopeFlags()) { 
+                 const StringBlock& names )
+{
     reader >> (RawSymbol&) *this;
 
     // pull our name out of the string table
-    name = (stable + st_name).ReadString();
+    name = names.At(st_name);
     UpdateFlags();
 
 }
 
-Flags::Mask Symbol::Flags_STT_NOTYPE = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STT_OBJECT = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STT_FUNC = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STT_SECTION = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STT_FILE = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STB_LOCAL = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STB_GLOBAL = Flags::EmptyMask;
-Flags::Mask Symbol::Flags_STB_WEAK = Flags::EmptyMask;
-
-const Flags& Symbol::TypeFlags() {
-    static unique_ptr<Flags> flags = NULL;
-
-    if ( !flags) {
-        flags = unique_ptr<Flags>(new Flags(""));
-
-        Flags_STT_NOTYPE = 
-            flags->AddFlag('U',"STT_NOTYPE");
-        Flags_STT_OBJECT = 
-            flags->AddFlag('O',"STT_OBJECT");
-        Flags_STT_FUNC = 
-            flags->AddFlag('P',"STT_FUNC");
-        Flags_STT_SECTION = 
-            flags->AddFlag('S',"STT_SECTION");
-        Flags_STT_FILE = 
-            flags->AddFlag('F',"STT_FILE");
-    }
-    return *flags;
-}
-
-const Flags& Symbol::ScopeFlags() {
-    static unique_ptr<Flags> flags = NULL;
-
-    if ( !flags) {
-        flags = unique_ptr<Flags>(new Flags(""));
-
-        Flags_STB_LOCAL = 
-            flags->AddFlag('L',"STB_LOCAL");
-        Flags_STB_GLOBAL = 
-            flags->AddFlag('G',"STB_GLOBAL");
-        Flags_STB_WEAK = 
-            flags->AddFlag('W',"STB_WEAK");
-    }
-
-    return *flags;
-}
+constexpr FlagDescriptor SymbolTypeTraits::descriptors[];
+constexpr FlagDescriptor SymbolScopeTraits::descriptors[];
 
 void Symbol::UpdateFlags() {
-    unsigned char infoMask = st_info;
-    unsigned char bindMask = ELF64_ST_BIND(infoMask);
-    unsigned char typeMask = ELF64_ST_TYPE(infoMask);
-    type.SetFlags(Flags_STT_NOTYPE,  typeMask == STT_NOTYPE );
-    type.SetFlags(Flags_STT_OBJECT,  typeMask == STT_OBJECT );
-    type.SetFlags(Flags_STT_FUNC,    typeMask == STT_FUNC );
-    type.SetFlags(Flags_STT_SECTION, typeMask == STT_SECTION );
-    type.SetFlags(Flags_STT_FILE,    typeMask == STT_FILE ); 
-    scope.SetFlags(Flags_STB_LOCAL,   bindMask == STB_LOCAL );
-    scope.SetFlags(Flags_STB_GLOBAL,  bindMask == STB_GLOBAL );
-    scope.SetFlags(Flags_STB_WEAK,    bindMask == STB_WEAK );
+    static_assert( Flags_STT_NOTYPE  == 1u << STT_NOTYPE &&
+                   Flags_STT_OBJECT  == 1u << STT_OBJECT &&
+                   Flags_STT_FUNC    == 1u << STT_FUNC &&
+                   Flags_STT_SECTION == 1u << STT_SECTION &&
+                   Flags_STT_FILE    == 1u << STT_FILE,
+                   "Symbol type flags don't match elf.h");
+    static_assert( Flags_STB_LOCAL  == 1u << STB_LOCAL &&
+                   Flags_STB_GLOBAL == 1u << STB_GLOBAL &&
+                   Flags_STB_WEAK   == 1u << STB_WEAK,
+                   "Symbol scope flags don't match elf.h");
+
+    // Flag i is type (binding) i: anything we don't have a flag for 
+    // gets none.
+    unsigned char typeMask = ELF64_ST_TYPE(st_info);
+    unsigned char bindMask = ELF64_ST_BIND(st_info);
+    type = SymbolTypeFlags( 
+        (1u << typeMask) & (Flags_STT_NOTYPE | Flags_STT_OBJECT | 
+                            Flags_STT_FUNC | Flags_STT_SECTION | 
+                            Flags_STT_FILE));
+    scope = SymbolScopeFlags(
+        (1u << bindMask) & (Flags_STB_LOCAL | Flags_STB_GLOBAL | 
+                            Flags_STB_WEAK));
 }
 
 string Symbol::LinkFormat() {
     ostringstream line;
-    if ( name == "" ) {
+    if ( name.Empty() ) {
         line <<  "__blank__ ";
     } else { 
         line << name << " ";
@@ -90,7 +59,7 @@ string Symbol::LinkFormat() {
 }
 
 bool Symbol::IsLinkSymbol () {
-    return name != "";
+    return !name.Empty();
 }
 
 string RawSymbol::Describe () const {
@@ -1,8 +1,10 @@
 #ifndef SYMBOL_H
    #define SYMBOL_H
-#include "flags.h"
+#include "flagSet.h"
 #include "elf.h"
+#include "nameView.h"
 class BinaryReader;
+class StringBlock;
 
 class RawSymbol: public Elf64_Sym { 
 public:
@@ -12,45 +14,76 @@ public:
     Elf64_Section& SectionIndex() { return st_shndx;}
     Elf64_Addr& Value() { return st_value;}
     Elf64_Xword& Size() { return st_size;}
+    Elf64_Word& NameOffset() { return st_name;}
 
     string Describe () const;
 };
 
+/*
+ * A symbol's type and binding, as LINK writes them. Flag i corresponds to
+ * STT_* / STB_* value i.
+ */
+struct SymbolTypeTraits {
+    static constexpr FlagDescriptor descriptors[] = {
+        { 'U', "STT_NOTYPE" },
+        { 'O', "STT_OBJECT" },
+        { 'P', "STT_FUNC" },
+        { 'S', "STT_SECTION" },
+        { 'F', "STT_FILE" }
+    };
+};
+typedef FlagSet<SymbolTypeTraits> SymbolTypeFlags;
+
+struct SymbolScopeTraits {
+    static constexpr FlagDescriptor descriptors[] = {
+        { 'L', "STB_LOCAL" },
+        { 'G', "STB_GLOBAL" },
+        { 'W', "STB_WEAK" }
+    };
+};
+typedef FlagSet<SymbolScopeTraits> SymbolScopeFlags;
+
 class Symbol: protected RawSymbol {
 public:
+    // Our name is a view into names, which must outlive us
     Symbol ( BinaryReader& reader, 
-             BinaryReader& stable );
+             const StringBlock& names );
     Symbol ( BinaryReader&& r, 
-             BinaryReader&& s): Symbol(r,s){}
+             const StringBlock& names): Symbol(r,names){}
     bool IsLinkSymbol();
     void UpdateFlags();
     string LinkFormat();
-    string Name() { return name;}
+    string Name() { return name.ToString();}
+    NameView NameRef() const { return name;}
 
     using RawSymbol::Value;
     using RawSymbol::SectionIndex;
     using RawSymbol::Size;
+    using RawSymbol::NameOffset;
 
     const RawSymbol& RawItem() { return *this;}
 
 protected:
-    // If we don't do this, we have to re-hash and bit manipulate the same
-    // 8 strings for every single symbol object we instantiate
-    static const Flags& TypeFlags();
-    static const Flags& ScopeFlags();
-
-    static Flags::Mask Flags_STT_NOTYPE;
-    static Flags::Mask Flags_STT_OBJECT;
-    static Flags::Mask Flags_STT_FUNC;
-    static Flags::Mask Flags_STT_SECTION;
-    static Flags::Mask Flags_STT_FILE;
-    static Flags::Mask Flags_STB_LOCAL;
-    static Flags::Mask Flags_STB_GLOBAL;
-    static Flags::Mask Flags_STB_WEAK;
+    static constexpr SymbolTypeFlags::Mask Flags_STT_NOTYPE = 
+        SymbolTypeFlags::Letter('U');
+    static constexpr SymbolTypeFlags::Mask Flags_STT_OBJECT = 
+        SymbolTypeFlags::Letter('O');
+    static constexpr SymbolTypeFlags::Mask Flags_STT_FUNC = 
+        SymbolTypeFlags::Letter('P');
+    static constexpr SymbolTypeFlags::Mask Flags_STT_SECTION = 
+        SymbolTypeFlags::Letter('S');
+    static constexpr SymbolTypeFlags::Mask Flags_STT_FILE = 
+        SymbolTypeFlags::Letter('F');
+    static constexpr SymbolScopeFlags::Mask Flags_STB_LOCAL = 
+        SymbolScopeFlags::Letter('L');
+    static constexpr SymbolScopeFlags::Mask Flags_STB_GLOBAL = 
+        SymbolScopeFlags::Letter('G');
+    static constexpr SymbolScopeFlags::Mask Flags_STB_WEAK = 
+        SymbolScopeFlags::Letter('W');
 
 private:
-    string name;
-    Flags type;
-    Flags scope;
+    NameView name;
+    SymbolTypeFlags type;
+    SymbolScopeFlags scope;
 };
 #endif
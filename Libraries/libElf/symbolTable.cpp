@@ -0,0 +1,159 @@
+#include "symbolTable.h"
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Number of raw symbols to read at once when splitting the table into
+ * columns
+ */
+static const size_t READ_BATCH = 4096;
+
+SymbolTable::SymbolTable (const BinaryReader& table, 
+                          size_t count,
+                          const BinaryReader& strs) 
+    : values(count), 
+      sizes(count),
+      nameOffsets(count),
+      sectionIndexes(count),
+      info(count),
+      other(count),
+      strings(strs)
+{
+    vector<Elf64_Sym> batch(count < READ_BATCH ? count: READ_BATCH);
+
+    for ( size_t start = 0; start < count; start += batch.size() ) {
+        size_t n = min(batch.size(), count - start);
+        (table + start * sizeof(Elf64_Sym)).Read(&batch[0], n * sizeof(Elf64_Sym));
+
+        for ( size_t i=0; i < n; ++i ) {
+            const Elf64_Sym& sym = batch[i];
+            values[start + i] = sym.st_value;
+            sizes[start + i] = sym.st_size;
+            nameOffsets[start + i] = sym.st_name;
+            sectionIndexes[start + i] = sym.st_shndx;
+            info[start + i] = sym.st_info;
+            other[start + i] = sym.st_other;
+        }
+    }
+}
+
+string SymbolTable::Name(size_t i) const {
+    return (strings + (long)nameOffsets[i]).ReadString();
+}
+
+bool SymbolTable::IsLinkSymbol(size_t i) const {
+    // Offset 0 is always the empty string, but other offsets may also 
+    // point at a null char
+    bool named = nameOffsets[i] != 0;
+    if ( named ) {
+        char first;
+        (strings + (long)nameOffsets[i]).Read(&first,1);
+        named = first != '\0';
+    }
+    return named;
+}
+
+Elf64_Sym SymbolTable::RawItem(size_t i) const {
+    Elf64_Sym sym;
+    sym.st_name = nameOffsets[i];
+    sym.st_info = info[i];
+    sym.st_other = other[i];
+    sym.st_shndx = sectionIndexes[i];
+    sym.st_value = values[i];
+    sym.st_size = sizes[i];
+    return sym;
+}
+
+vector<size_t> SymbolTable::LinkSymbols() const {
+    vector<size_t> matches;
+    // The cheap test first: only symbols with a non-zero name offset
+    // can have a name
+    for ( size_t i=0; i < nameOffsets.size(); ++i ) {
+        if ( nameOffsets[i] != 0 && IsLinkSymbol(i) ) {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+size_t SymbolTable::CountLinkSymbols() const {
+    size_t count = 0;
+    for ( size_t i=0; i < nameOffsets.size(); ++i ) {
+        if ( nameOffsets[i] != 0 && IsLinkSymbol(i) ) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+vector<size_t> SymbolTable::Matching(const vector<unsigned char>& column,
+                                     unsigned char value,
+                                     unsigned char mask) const
+{
+    vector<size_t> matches;
+    const unsigned char* data = column.data();
+    const size_t n = column.size();
+    for ( size_t i=0; i < n; ++i ) {
+        if ( (data[i] & mask) == value ) {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+vector<size_t> SymbolTable::OfType(unsigned char type) const {
+    return Matching(info, ELF64_ST_TYPE(type), 0xf);
+}
+
+vector<size_t> SymbolTable::WithBinding(unsigned char binding) const {
+    return Matching(info, ELF64_ST_INFO(binding,0), 0xf0);
+}
+
+vector<size_t> SymbolTable::InSection(Elf64_Section section) const {
+    vector<size_t> matches;
+    const Elf64_Section* data = sectionIndexes.data();
+    const size_t n = sectionIndexes.size();
+    for ( size_t i=0; i < n; ++i ) {
+        if ( data[i] == section ) {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+const vector<uint32_t>& SymbolTable::ByAddress() const {
+    if ( byAddress.size() != values.size() ) {
+        byAddress.resize(values.size());
+        for ( size_t i=0; i < byAddress.size(); ++i ) {
+            byAddress[i] = i;
+        }
+
+        // Stable, so symbols at the same address stay in table order
+        const vector<Elf64_Addr>& v = values;
+        stable_sort(byAddress.begin(), byAddress.end(),
+                    [&v] (uint32_t lhs, uint32_t rhs) -> bool {
+                        return v[lhs] < v[rhs];
+                    });
+
+        sortedValues.resize(values.size());
+        for ( size_t i=0; i < byAddress.size(); ++i ) {
+            sortedValues[i] = values[byAddress[i]];
+        }
+    }
+    return byAddress;
+}
+
+vector<size_t> SymbolTable::InRange(Elf64_Addr start, Elf64_Addr end) const {
+    const vector<uint32_t>& sorted = ByAddress();
+
+    auto first = lower_bound(sortedValues.begin(), sortedValues.end(), start);
+    auto last = lower_bound(first, sortedValues.end(), end);
+
+    vector<size_t> matches;
+    matches.reserve(last - first);
+    for ( auto it = first; it != last; ++it ) {
+        matches.push_back(sorted[it - sortedValues.begin()]);
+    }
+    return matches;
+}
@@ -0,0 +1,99 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "elf.h"
+#include "binaryReader.h"
+
+using namespace std;
+
+/**
+    \class   SymbolTable
+    \brief   Column-wise (struct of arrays) copy of an ELF symbol table
+    \details Rather than one heap object per symbol, each field of the 
+             table is held in its own contiguous array. Queries which only
+             look at one or two fields (all the functions, everything in
+             section 3, every symbol between two addresses) are then tight
+             loops over packed data, which the compiler is free to
+             vectorise.
+
+             Names are not read until they are asked for: the table only
+             stores the offset of each name in .strtab.
+*/
+class SymbolTable {
+public:
+    /*
+     * Read count symbols from table, whose names are in strings
+     */
+    SymbolTable (const BinaryReader& table, 
+                 size_t count,
+                 const BinaryReader& strings);
+
+    SymbolTable (BinaryReader&& t, size_t c, BinaryReader&& s)
+        : SymbolTable(t,c,s) {}
+
+    size_t Size() const { return values.size(); }
+
+    // Per symbol fields
+    Elf64_Addr Value(size_t i) const { return values[i]; }
+    Elf64_Xword SymbolSize(size_t i) const { return sizes[i]; }
+    Elf64_Section SectionIndex(size_t i) const { return sectionIndexes[i]; }
+    Elf64_Word NameOffset(size_t i) const { return nameOffsets[i]; }
+    unsigned char Info(size_t i) const { return info[i]; }
+    unsigned char Other(size_t i) const { return other[i]; }
+    unsigned char Type(size_t i) const { return ELF64_ST_TYPE(info[i]); }
+    unsigned char Binding(size_t i) const { return ELF64_ST_BIND(info[i]); }
+
+    // Read the name from the string table
+    string Name(size_t i) const;
+
+    // Equivalent to Symbol::IsLinkSymbol: does the symbol have a name?
+    bool IsLinkSymbol(size_t i) const;
+
+    // Re-assemble the raw ELF symbol
+    Elf64_Sym RawItem(size_t i) const;
+
+    /*
+     * Whole table filters: each returns the (ascending) indexes of the
+     * matching symbols.
+     */
+    vector<size_t> LinkSymbols() const;
+    vector<size_t> OfType(unsigned char type) const;
+    vector<size_t> WithBinding(unsigned char binding) const;
+    vector<size_t> InSection(Elf64_Section section) const;
+
+    size_t CountLinkSymbols() const;
+
+    /*
+     * Address queries: the indexes of every symbol whose value is in 
+     * [start, end), sorted by value. 
+     *
+     * The first call sorts the table by address, so is O(n log(n)), after
+     * which each query is O(log(n) + matches).
+     */
+    vector<size_t> InRange(Elf64_Addr start, Elf64_Addr end) const;
+
+    // Symbol indexes, sorted by value
+    const vector<uint32_t>& ByAddress() const;
+
+private:
+    vector<size_t> Matching(const vector<unsigned char>& column, 
+                            unsigned char value,
+                            unsigned char mask) const;
+
+    // Columns
+    vector<Elf64_Addr> values;
+    vector<Elf64_Xword> sizes;
+    vector<Elf64_Word> nameOffsets;
+    vector<Elf64_Section> sectionIndexes;
+    vector<unsigned char> info;
+    vector<unsigned char> other;
+
+    BinaryReader strings;
+
+    // Lazily built address index
+    mutable vector<uint32_t> byAddress;
+    mutable vector<Elf64_Addr> sortedValues;
+};
+#endif
@@ -69,9 +69,8 @@ bool ExecBuilder::UpdateSymbolValue(string name, long value) {
     bool ret = false;
     BinaryWriter symWrite = writer + symTabHeader.DataStart();
 
-    auto loc = content.symbolMap.find(name);
-    if ( loc != content.symbolMap.end() ) {
-        int& idx = loc->second;
+    int idx = content.symbolMap.Find(name);
+    if ( idx != NameIndex::NOT_FOUND ) {
 
         // Update the cache
         Symbol& sym = *(content.symbols[idx]);
@@ -0,0 +1,116 @@
+#include <vector>
+#include "tester.h"
+#include "nameIndex.h"
+#include <map>
+#include <sstream>
+#include <iostream>
+
+using namespace std;
+
+int Lookup(testLogger& log);
+int Replace(testLogger& log);
+int Growth(testLogger& log);
+int Iterate(testLogger& log);
+
+const vector<string> testStrings = vector<string>( 
+      {"", ".text", ".rela.text", ".data", "_start", "main" });
+
+int main(int argc, const char *argv[])
+{
+    Test("Names can be found once added", (loggedTest)Lookup).RunTest();
+    Test("Re-adding a name replaces the value", (loggedTest)Replace).RunTest();
+    Test("Lots of names (re-hashing)", (loggedTest)Growth).RunTest();
+    Test("Iteration is in insertion order", (loggedTest)Iterate).RunTest();
+    return 0;
+}
+
+int Lookup(testLogger& log) {
+    NameIndex index;
+    for ( size_t i=0; i< testStrings.size(); ++i ) {
+        index.Set(testStrings[i],i);
+    }
+    for ( size_t i=0; i< testStrings.size(); ++i ) {
+        int found = index.Find(testStrings[i]);
+        log << ">" << testStrings[i] << "< : " << found << endl;
+        if ( found != (int)i ) {
+            log << "Expected " << i << endl;
+            return 1;
+        }
+    }
+
+    if ( index.Find(".bss") != NameIndex::NOT_FOUND ) {
+        log << "Found a name we never added!" << endl;
+        return 2;
+    }
+
+    // A prefix of a name is a different name
+    if ( index.Find(".rela") != NameIndex::NOT_FOUND ) {
+        log << "Found a prefix of a name" << endl;
+        return 3;
+    }
+    return 0;
+}
+
+int Replace(testLogger& log) {
+    NameIndex index;
+    index.Set("_start",1);
+    index.Set("_start",5);
+    if ( index.Find("_start") != 5 ) {
+        log << "Value was not replaced: " << index.Find("_start") << endl;
+        return 1;
+    }
+    if ( index.Size() != 1 ) {
+        log << "Duplicate entry: " << index.Size() << endl;
+        return 2;
+    }
+    return 0;
+}
+
+int Growth(testLogger& log) {
+    NameIndex index;
+    map<string,int> reference;
+    for ( int i=0; i < 100000; ++i ) {
+        ostringstream name;
+        name << "symbol_" << i % 70000;
+        index.Set(name.str(),i);
+        reference[name.str()] = i;
+    }
+
+    if ( index.Size() != reference.size() ) {
+        log << "Size missmatch: " << index.Size();
+        log << " , " << reference.size() << endl;
+        return 1;
+    }
+
+    for ( auto& pair: reference ) {
+        if ( index.Find(pair.first) != pair.second ) {
+            log << "Missmatch for " << pair.first << ": ";
+            log << index.Find(pair.first) << " , " << pair.second << endl;
+            return 2;
+        }
+    }
+
+    NameIndex copy(index);
+    if ( copy != index ) {
+        log << "Copy is not the same as the original" << endl;
+        return 3;
+    }
+    return 0;
+}
+
+int Iterate(testLogger& log) {
+    NameIndex index;
+    for ( size_t i=0; i< testStrings.size(); ++i ) {
+        index.Set(testStrings[i],10 * i);
+    }
+
+    size_t i = 0;
+    for ( const NameIndex::Entry& entry: index ) {
+        log << i << ": " << entry.Name() << " -> " << entry.Index() << endl;
+        if ( entry.Name() != testStrings[i] || entry.Index() != (int)(10*i) ) {
+            return 1;
+        }
+        ++i;
+    }
+    return i == testStrings.size() ? 0 : 2;
+}
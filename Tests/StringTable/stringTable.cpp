@@ -10,6 +10,8 @@ using namespace std;
 int insert(testLogger& log);
 int tabSize(testLogger& log);
 int WriteTable(testLogger& log);
+int dedup(testLogger& log);
+int tailMerge(testLogger& log);
 
 const vector<const char *> testStrings = vector<const char *>( 
       {"STRING_1", "Test string two", "the same string", "the same string" });
@@ -19,6 +21,8 @@ int main(int argc, const char *argv[])
     Test("It is possible to insert a string?", (loggedTest)insert).RunTest();
     Test("Validate the size function", (loggedTest)tabSize).RunTest();
     Test("Validate output table", (loggedTest)WriteTable).RunTest();
+    Test("Repeated strings are only stored once", (loggedTest)dedup).RunTest();
+    Test("Tails of other strings are shared", (loggedTest)tailMerge).RunTest();
     return 0;
 }
 
@@ -33,6 +37,10 @@ int insert(testLogger& log) {
 		log << "lastLoc: " << lastLoc << endl;
 		log << "lastLen: " << lastLen << endl;
 		log << "loc: "     << loc << endl;
+        if ( loc == lastLoc && lastLen == (int)strlen(str) + 1 ) {
+            // repeated string - should have been re-used
+            continue;
+        }
         if ( lastLoc + lastLen != loc ) {
             log << "Expected " << lastLoc + lastLen;
             log << " but got " << loc << endl;
@@ -49,10 +57,14 @@ int insert(testLogger& log) {
 int tabSize (testLogger& log) {
     int lastLen=1;
     StringTable tab;
+    const char * last = "";
     for( const char * const & str: testStrings) {
 		log << "Adding: >" << str << "< ...";
         tab.AddString(str);
 		int len = strlen(str) +1; //null char
+        if ( strcmp(str,last) == 0 ) {
+            len = 0; // already in the table
+        }
 		log << "(" << len << ")" << "done"  << endl;
         if ( tab.Size() != lastLen + len ) {
             log << "Expected " << lastLen+ len;
@@ -60,10 +72,49 @@ int tabSize (testLogger& log) {
             return 1;
         }
 		lastLen += len;
+        last = str;
     }
 	return 0;
 }
 
+/*
+ * Adding a string a second time should give back the original copy
+ */
+int dedup (testLogger& log) {
+    StringTable tab;
+    long first = tab.AddString(testStrings[2]);
+    long other = tab.AddString(testStrings[0]);
+    long size = tab.Size();
+
+    long second = tab.AddString(string(testStrings[3]));
+    if ( second != first ) {
+        log << "Expected repeated string at " << first;
+        log << " but got " << second << endl;
+        return 1;
+    }
+
+    if ( tab.AddString(testStrings[0]) != other ) {
+        log << "Second string was not re-used" << endl;
+        return 1;
+    }
+
+    if ( tab.Size() != size ) {
+        log << "Table grew from " << size << " to " << tab.Size() << endl;
+        return 1;
+    }
+
+    if ( tab.AddString("") != 0 ) {
+        log << "The empty string should be the leading null" << endl;
+        return 1;
+    }
+
+    if ( tab.Size() != size ) {
+        log << "Empty string grew the table" << endl;
+        return 1;
+    }
+    return 0;
+}
+
 /*
  * We're building this
  * "\0<string 1>\0<string 2>\0<string 3>\0"
@@ -127,3 +178,57 @@ int WriteTable (testLogger& log) {
 	return 0;
 }
 
+
+/*
+ * In TAIL_MERGE mode, strings which end another string should point
+ * into it
+ */
+int tailMerge (testLogger& log) {
+    const vector<const char *> names = vector<const char *>( 
+        {".text", ".rela.text", ".data", "text", ".rela.data", ".bss", "xt"});
+    StringTable tab(StringTable::TAIL_MERGE);
+
+    vector<long> handles;
+    for ( const char * name: names ) {
+        handles.push_back(tab.AddString(name));
+    }
+
+    // Only ".rela.text", ".rela.data" and ".bss" need to be stored
+    long expectedSize = 1 + strlen(".rela.text") + 1 
+                          + strlen(".rela.data") + 1
+                          + strlen(".bss") + 1;
+    if ( tab.Size() != expectedSize ) {
+        log << "Expected a table of " << expectedSize;
+        log << " bytes but got " << tab.Size() << endl;
+        return 1;
+    }
+
+    DataLump<100> outTable;
+    tab.WriteTable(outTable);
+    const char * outArr = (const char *) outTable.RawPtr();
+
+    if ( outArr[0] != '\0' ) {
+        log << "Table does not start with a null" << endl;
+        return 1;
+    }
+
+    for ( size_t i=0; i < names.size(); ++i ) {
+        long offset = tab.Offset(handles[i]);
+        log << names[i] << " -> " << offset << endl;
+        if ( offset <= 0 || offset >= tab.Size() ) {
+            log << "Invalid offset!" << endl;
+            return 1;
+        }
+        if ( strcmp(outArr + offset, names[i]) != 0 ) {
+            log << "Expected " << names[i] << " but got ";
+            log << (outArr + offset) << endl;
+            return 1;
+        }
+    }
+
+    if ( tab.Offset(tab.AddString("")) != 0 ) {
+        log << "The empty string should be the leading null" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Check each of the vectorised byte scanning kernels against the scalar
+ * implementation, and then time them on a synthetic string table.
+ *
+ * Usage: byteScan [table size in MiB]
+ */
+#include "byteScan.h"
+#include "tester.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+long tableSize = 64 * 1024 * 1024;
+
+int Find(testLogger& log);
+int FindLast(testLogger& log);
+int FindAll(testLogger& log);
+void BuildTable(vector<char>& table, long size);
+double TimeScan(const ByteScan& scan, const vector<char>& table, size_t& count);
+
+// Every kernel this machine can run
+vector<ByteScan> kernels;
+
+// Random blocks, with few enough matches that the vector loops get to run
+vector<char> block;
+
+int main(int argc, const char *argv[])
+{
+    if ( argc > 1 ) {
+        tableSize = atol(argv[1]) * 1024 * 1024;
+    }
+
+    ByteScan::Kernel all[] = {ByteScan::SCALAR, ByteScan::SSE2, ByteScan::AVX2};
+    for ( ByteScan::Kernel k: all ) {
+        if ( ByteScan::Supported(k) ) {
+            kernels.push_back(ByteScan(k));
+        }
+    }
+
+    srand(42);
+    block.resize(512);
+    for ( char& c: block ) {
+        c = (rand() % 40 == 0) ? '\0' : 'a' + rand() % 26;
+    }
+
+    Test("Find matches the scalar kernel",Find).RunTest();
+    Test("FindLast matches the scalar kernel",FindLast).RunTest();
+    Test("FindAll matches the scalar kernel",FindAll).RunTest();
+
+    vector<char> table;
+    BuildTable(table, tableSize);
+
+    cout << "Splitting a " << table.size() / (1024*1024) << "MiB string table" << endl;
+    cout << "  Best kernel: " << ByteScan::Best().Name() << endl;
+    double scalar = 0;
+    for ( const ByteScan& scan: kernels ) {
+        size_t count = 0;
+        double time = TimeScan(scan, table, count);
+        if ( scan.Type() == ByteScan::SCALAR ) {
+            scalar = time;
+        }
+        cout << "  " << scan.Name() << ": " << time << "s, ";
+        cout << count << " strings";
+        if ( scalar > 0 ) {
+            cout << " (x" << scalar / time << ")";
+        }
+        cout << endl;
+    }
+    return 0;
+}
+
+/*
+ * Every kernel must give the same answer for every start alignment and 
+ * length (including the short tails handled by the scalar code)
+ */
+int Find(testLogger& log) {
+    const ByteScan scalar(ByteScan::SCALAR);
+    for ( const ByteScan& scan: kernels ) {
+        for ( size_t start = 0; start < 64; ++start ) {
+            for ( size_t len = 0; start + len <= block.size(); ++len ) {
+                const char* b = block.data() + start;
+                const char* e = b + len;
+                for ( unsigned char c: {'\0', 'q'} ) {
+                    if ( scan.Find(b,e,c) != scalar.Find(b,e,c) ) {
+                        log << scan.Name() << " Find missmatch: start " << start;
+                        log << ", length " << len << endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+
+        // Nothing to find
+        vector<char> empty(100,'x');
+        const char* e = empty.data() + empty.size();
+        if ( scan.Find(empty.data(), e, '\0') != e ) {
+            log << scan.Name() << " found a missing character" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int FindLast(testLogger& log) {
+    const ByteScan scalar(ByteScan::SCALAR);
+    for ( const ByteScan& scan: kernels ) {
+        for ( size_t start = 0; start < 64; ++start ) {
+            for ( size_t len = 0; start + len <= block.size(); ++len ) {
+                const char* b = block.data() + start;
+                const char* e = b + len;
+                for ( unsigned char c: {'\0', 'q'} ) {
+                    if ( scan.FindLast(b,e,c) != scalar.FindLast(b,e,c) ) {
+                        log << scan.Name() << " FindLast missmatch: start ";
+                        log << start << ", length " << len << endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+
+        vector<char> empty(100,'x');
+        if ( scan.FindLast(empty.data(), empty.data() + empty.size(), '\0') ) {
+            log << scan.Name() << " found a missing character" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int FindAll(testLogger& log) {
+    const ByteScan scalar(ByteScan::SCALAR);
+    for ( const ByteScan& scan: kernels ) {
+        for ( size_t start = 0; start < 64; ++start ) {
+            for ( size_t len = 0; start + len <= block.size(); len += 7 ) {
+                const char* b = block.data() + start;
+                const char* e = b + len;
+
+                // Results are appended to whatever is already there
+                vector<long> expected(1,-1);
+                vector<long> found(1,-1);
+                size_t n = scalar.FindAll(b,e,'\0',expected);
+                if ( scan.FindAll(b,e,'\0',found) != n || found != expected ) {
+                    log << scan.Name() << " FindAll missmatch: start ";
+                    log << start << ", length " << len << endl;
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Something like a large .strtab: mangled C++ names of 10-80 characters
+ */
+void BuildTable(vector<char>& table, long size) {
+    table.reserve(size);
+    table.push_back('\0');
+    while ( (long)table.size() < size ) {
+        long len = 10 + rand() % 70;
+        for ( long i = 0; i < len; ++i ) {
+            table.push_back('A' + rand() % 58);
+        }
+        table.push_back('\0');
+    }
+}
+
+double TimeScan(const ByteScan& scan, const vector<char>& table, size_t& count) {
+    vector<long> ends;
+    ends.reserve(table.size() / 16);
+
+    auto start = chrono::steady_clock::now();
+    count = scan.FindAll(table.data(), table.data() + table.size(), '\0', ends);
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double>(end - start).count();
+}
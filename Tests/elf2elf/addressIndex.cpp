@@ -0,0 +1,120 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "addressIndex.h"
+#include "tester.h"
+#include <elf.h>
+#include <vector>
+
+/*
+ * Look up sections and segments in isYes/a.out, and compare with what a
+ * scan of every section finds
+ */
+
+using namespace std;
+
+int Addresses(testLogger& log );
+int Offsets(testLogger& log );
+int Segments(testLogger& log );
+int Within(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Finding sections by address",Addresses).RunTest();
+    Test("Finding sections by file offset",Offsets).RunTest();
+    Test("Finding the segment for an address",Segments).RunTest();
+    Test("Sections within part of the file",Within).RunTest();
+    return 0;
+}
+
+int Addresses(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    vector<Section*>& sections = p.Content().sections;
+    AddressIndex index(sections);
+
+    for ( size_t i = 0; i < sections.size(); ++i ) {
+        const Section& sec = *sections[i];
+        if ( sec.Address() == 0 || sec.DataSize() == 0 ) {
+            continue;
+        }
+        if (    index.SectionAt(sec.Address()) != (long)i
+             || index.SectionAt(sec.AddrEnd() - 1) != (long)i )
+        {
+            log << "Didn't find " << sec.NameRef().ToString() << endl;
+            return 1;
+        }
+    }
+    if ( index.SectionAt(0x10) != AddressIndex::NOT_FOUND ) {
+        log << "Found a section at 0x10" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Offsets(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    vector<Section*>& sections = p.Content().sections;
+    AddressIndex index(sections);
+
+    long text = p.Content().sectionMap.Find(".text");
+    const Section& sec = *sections[text];
+    if ( index.SectionAtOffset(sec.DataStart() + 4) != text ) {
+        log << "Didn't find .text" << endl;
+        return 1;
+    }
+
+    // .bss has no data in the file
+    long bss = p.Content().sectionMap.Find(".bss");
+    long found = index.SectionAtOffset(sections[bss]->DataStart());
+    if ( found == bss ) {
+        log << "Found .bss in the file" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Segments(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    AddressIndex index(p.Content().sections, p.Content().progHeaders);
+
+    const Section& text = *p.Content().GetSection(".text");
+    long segment = index.SegmentAt(text.Address());
+    if ( segment == AddressIndex::NOT_FOUND ) {
+        log << "No segment for .text" << endl;
+        return 1;
+    }
+    const ProgramHeader& code = *p.Content().progHeaders[segment];
+    if ( !code.IsLoadableSegment() || !code.IsExecutable() ) {
+        log << ".text isn't in an executable segment" << endl;
+        return 1;
+    }
+    return index.SegmentAt(0x10) == AddressIndex::NOT_FOUND ? 0 : 1;
+}
+
+int Within(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    vector<Section*>& sections = p.Content().sections;
+    AddressIndex index(sections);
+
+    for ( const ProgramHeader* segment : p.Content().progHeaders ) {
+        vector<size_t> expected;
+        for ( size_t i = 0; i < sections.size(); ++i ) {
+            if (    sections[i]->DataStart() >= segment->DataStart()
+                 && sections[i]->DataEnd() <= segment->DataEnd() )
+            {
+                expected.push_back(i);
+            }
+        }
+        vector<size_t> found =
+            index.SectionsWithin(segment->DataStart(), segment->DataEnd());
+        if ( found != expected ) {
+            log << "Found " << found.size() << " sections, expected "
+                << expected.size() << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
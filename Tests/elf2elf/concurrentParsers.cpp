@@ -0,0 +1,88 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "tester.h"
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Parse the same files on lots of threads at once: every parse must see
+ * exactly what a parse on its own would.
+ *
+ * No file is parsed before the threads start, so that they race to build
+ * the shared flag tables. Build with -fsanitize=thread to have the race
+ * detector check the library as well: this test should run clean.
+ */
+
+using namespace std;
+
+const char* FILES[] = { "isYes/a.out", "isYes/isYes.o" };
+const int THREADS = 8;
+const int PARSES_PER_THREAD = 25;
+
+int Concurrent(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Parsing on many threads at once",Concurrent).RunTest();
+    return 0;
+}
+
+/*
+ * Everything the parser can tell us about the file
+ */
+string Describe(const string& fname, int hints, int symbolThreads) {
+    ElfFileReader f(fname, hints);
+    ElfParserOptions options;
+    options.symbolThreads = symbolThreads;
+    ElfParser p(f, options);
+
+    ostringstream out;
+    out << p.PrintLink();
+    ElfContent content = p.Content();
+    for ( Section* sec: content.sections ) {
+        out << sec->Descripe() << endl;
+    }
+    for ( Symbol* sym: content.symbols ) {
+        out << sym->LinkFormat() << endl;
+    }
+    return out.str();
+}
+
+int Concurrent(testLogger& log ) {
+    vector<vector<string> > results(THREADS);
+    vector<thread> workers;
+    for ( int t = 0; t < THREADS; ++t ) {
+        workers.push_back(thread([t, &results] () {
+            for ( int i = 0; i < PARSES_PER_THREAD; ++i ) {
+                // Mix private and shared mappings, and serial and
+                // parallel symbol decodes
+                int hints = i % 2 ? ElfFileReader::READ_CACHED
+                                  : ElfFileReader::READ_DEFAULT;
+                results[t].push_back(Describe(FILES[(t + i) % 2],
+                                              hints,
+                                              i % 3 + 1));
+            }
+        }));
+    }
+    for ( thread& worker: workers ) {
+        worker.join();
+    }
+
+    string expected[2] = { Describe(FILES[0], 0, 1),
+                           Describe(FILES[1], 0, 1) };
+
+    for ( int t = 0; t < THREADS; ++t ) {
+        for ( int i = 0; i < PARSES_PER_THREAD; ++i ) {
+            if ( results[t][i] != expected[(t + i) % 2] ) {
+                log << "Thread " << t << " parse " << i << " of ";
+                log << FILES[(t + i) % 2] << " differs:" << endl;
+                log << results[t][i] << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
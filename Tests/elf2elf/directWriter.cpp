@@ -0,0 +1,163 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "buildElf.h"
+#include "dataVector.h"
+#include "streamReader.h"
+#include "tester.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * ElfFile can write straight to a file on disk: it should produce exactly
+ * the same bytes as writing through a BinaryWriter
+ */
+
+using namespace std;
+
+int ObjectFile(testLogger& log );
+int Executable(testLogger& log );
+int Rewritten(testLogger& log );
+int Cached(testLogger& log );
+int Streamed(testLogger& log );
+int Rebuilt(testLogger& log );
+int RebuiltCached(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Writing an object file directly",ObjectFile).RunTest();
+    Test("Writing an executable directly",Executable).RunTest();
+    Test("Writing a section that has been copied",Rewritten).RunTest();
+    Test("Copying from a shared mapping",Cached).RunTest();
+    Test("Copying from a stream",Streamed).RunTest();
+    Test("Writing the same content twice",Rebuilt).RunTest();
+    Test("Writing the same content twice from a shared mapping",
+         RebuiltCached).RunTest();
+    return 0;
+}
+
+string ReadBack(const string& path) {
+    ifstream in(path.c_str(), ios::binary);
+    stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+int Compare(testLogger& log, ElfFile& file, const string& path) {
+    DataVector image;
+    file.WriteToFile(image.Writer());
+    vector<char> expected(image.Size());
+    image.Reader().Read(expected.data(), image.Size());
+
+    file.WriteToFile(path);
+    string written = ReadBack(path);
+
+    log << "Expected " << file.Size() << " bytes, wrote "
+        << written.size() << endl;
+    if (    (long)file.Size() != image.Size()
+         || written.size() != expected.size() )
+    {
+        return 1;
+    }
+    if ( written != string(expected.begin(), expected.end()) ) {
+        log << "Contents differ" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int ObjectFile(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    ElfParser p(f);
+    ElfFile file(p.Content());
+    return Compare(log, file, "/tmp/directWriter.o");
+}
+
+int Executable(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    ElfFile file(p.Content());
+    return Compare(log, file, "/tmp/directWriter");
+}
+
+int Rewritten(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    Section* text = p.Content().GetSection(".text");
+    if ( !text ) {
+        log << "No .text section!" << endl;
+        return 1;
+    }
+    // No longer a view on the input
+    text->GetData();
+
+    ElfFile file(p.Content());
+    return Compare(log, file, "/tmp/directWriter");
+}
+
+int Cached(testLogger& log ) {
+    ElfFileReader f("isYes/a.out", ElfFileReader::READ_CACHED);
+    if ( f.Fd() < 0 ) {
+        log << "No descriptor for the input" << endl;
+        return 1;
+    }
+    ElfParser p(f);
+    ElfFile file(p.Content());
+    return Compare(log, file, "/tmp/directWriter");
+}
+
+/*
+ * No descriptor to copy from: everything goes through user space
+ */
+int Streamed(testLogger& log ) {
+    int fd = open("isYes/a.out", O_RDONLY);
+    StreamReader stream(fd);
+    ElfParser p(stream);
+    ElfFile file(p.Content());
+    int result = Compare(log, file, "/tmp/directWriter");
+    close(fd);
+    return result;
+}
+
+/*
+ * Writing a file moves its sections: a second file built from the same
+ * content must still copy from where they were in the input
+ */
+int Rebuild(testLogger& log, ElfFileReader& f) {
+    ElfParser p(f);
+    ElfFile first(p.Content());
+    if ( Compare(log, first, "/tmp/directWriter.o") != 0 ) {
+        return 1;
+    }
+    string written = ReadBack("/tmp/directWriter.o");
+
+    ElfFile second(p.Content());
+    if ( Compare(log, second, "/tmp/directWriter.o") != 0 ) {
+        return 1;
+    }
+    if ( ReadBack("/tmp/directWriter.o") != written ) {
+        log << "Second file differs from the first" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Rebuilt(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    return Rebuild(log, f);
+}
+
+/*
+ * The kernel copies from the mapping's descriptor, by the same offsets
+ */
+int RebuiltCached(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o", ElfFileReader::READ_CACHED);
+    if ( f.Fd() < 0 ) {
+        log << "No descriptor for the input" << endl;
+        return 1;
+    }
+    return Rebuild(log, f);
+}
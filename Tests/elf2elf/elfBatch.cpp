@@ -0,0 +1,245 @@
+#include "elfBatch.h"
+#include "elfParser.h"
+#include "elfReader.h"
+#include "buildElf.h"
+#include "tester.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+
+/*
+ * Batch runs must give the same output as running the files one at a
+ * time, in the same order, however long each file takes.
+ */
+
+using namespace std;
+
+int Order(testLogger& log );
+int Failures(testLogger& log );
+int InFlight(testLogger& log );
+int Inputs(testLogger& log );
+int PrintLinks(testLogger& log );
+int Rerun(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Output is in input order",Order).RunTest();
+    Test("A failed file doesn't stop the batch",Failures).RunTest();
+    Test("Files in flight are limited",InFlight).RunTest();
+    Test("Reading directories and file lists",Inputs).RunTest();
+    Test("Batch PrintLink matches single files",PrintLinks).RunTest();
+    Test("Re-running a directory batch",Rerun).RunTest();
+    return 0;
+}
+
+vector<string> Numbers(int count) {
+    vector<string> inputs;
+    for ( int i = 0; i < count; ++i ) {
+        inputs.push_back(to_string(i));
+    }
+    return inputs;
+}
+
+int Order(testLogger& log ) {
+    vector<string> inputs = Numbers(200);
+    ostringstream expected;
+    for ( const string& input: inputs ) {
+        expected << input << endl;
+    }
+
+    // Later files finish first
+    ElfBatch::Job job = [] (const string& input, ostream& out) {
+        this_thread::sleep_for(chrono::microseconds(200 - stoi(input)));
+        out << input << endl;
+    };
+
+    ostringstream out;
+    ostringstream err;
+    size_t failed = ElfBatch(7).Run(inputs, job, out, err);
+    if ( failed != 0 || out.str() != expected.str() ) {
+        log << "Bad output: " << out.str() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Failures(testLogger& log ) {
+    vector<string> inputs = Numbers(50);
+    ElfBatch::Job job = [] (const string& input, ostream& out) {
+        if ( stoi(input) % 10 == 3 ) {
+            throw string("unlucky");
+        }
+        out << input << endl;
+    };
+
+    ostringstream out;
+    ostringstream err;
+    size_t failed = ElfBatch(4).Run(inputs, job, out, err);
+    log << err.str();
+    if ( failed != 5 ) {
+        log << "Expected 5 failures, got " << failed << endl;
+        return 1;
+    }
+    if ( err.str().find("43: unlucky") == string::npos ) {
+        log << "The failure wasn't reported" << endl;
+        return 1;
+    }
+    if ( out.str().find("\n3\n") != string::npos ) {
+        log << "Output from a failed file" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * While file 1 is stuck nothing more than maxInFlight files on can start
+ */
+int InFlight(testLogger& log ) {
+    const int maxInFlight = 4;
+    atomic<bool> stuck(true);
+    atomic<int> highest(0);
+    ElfBatch::Job job = [&] (const string& input, ostream&) {
+        int i = stoi(input);
+        if ( i == 1 ) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            stuck = false;
+        } else if ( stuck && i > highest ) {
+            highest = i;
+        }
+    };
+
+    ostringstream out;
+    ostringstream err;
+    ElfBatch(3, maxInFlight).Run(Numbers(100), job, out, err);
+    log << "Highest file started: " << highest << endl;
+    if ( highest >= 1 + maxInFlight ) {
+        return 1;
+    }
+    return 0;
+}
+
+int Inputs(testLogger& log ) {
+    vector<string> files = ElfBatch::Inputs("isYes");
+    for ( const string& file: files ) {
+        log << file << endl;
+    }
+    // isYes.c isn't an ELF file
+    if (    files.size() != 2
+         || files[0] != "isYes/a.out"
+         || files[1] != "isYes/isYes.o" )
+    {
+        log << "Bad directory listing" << endl;
+        return 1;
+    }
+
+    ofstream list("batchList.txt");
+    list << "isYes/isYes.o" << endl << endl << "isYes/a.out  " << endl;
+    list.close();
+
+    files = ElfBatch::Inputs("batchList.txt");
+    if (    files.size() != 2
+         || files[0] != "isYes/isYes.o"
+         || files[1] != "isYes/a.out" )
+    {
+        log << "Bad file list" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+string PrintLink(const string& input) {
+    ElfFileReader f(input);
+    ElfParserOptions options;
+    options.lazy = true;
+    ElfParser p(f, options);
+    return p.PrintLink();
+}
+
+int PrintLinks(testLogger& log ) {
+    vector<string> inputs;
+    for ( int i = 0; i < 20; ++i ) {
+        inputs.push_back( i % 2 ? "isYes/a.out" : "isYes/isYes.o");
+    }
+
+    string expected;
+    for ( const string& input: inputs ) {
+        expected += PrintLink(input) + "\n";
+    }
+
+    ElfBatch::Job job = [] (const string& input, ostream& out) {
+        out << PrintLink(input) << endl;
+    };
+    ostringstream out;
+    ostringstream err;
+    size_t failed = ElfBatch(4, 6).Run(inputs, job, out, err);
+    if ( failed != 0 || out.str() != expected ) {
+        log << "Batch output differs: " << err.str() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+void Copy(const string& from, const string& to) {
+    ifstream in(from.c_str(), ios::binary);
+    ofstream out(to.c_str(), ios::binary);
+    out << in.rdbuf();
+}
+
+/*
+ * As elf2elf's batch mode: write each file next to its input
+ */
+size_t Rewrite(const string& dir, vector<string>& inputs, ostream& err) {
+    inputs = ElfBatch::Inputs(dir, ".out");
+    ElfBatch::Job job = [] (const string& input, ostream& out) {
+        ElfFileReader f(input);
+        ElfParser p(f);
+        ElfFile file(p.Content());
+        file.WriteToFile(input + ".out");
+        out << input << endl;
+    };
+    ostringstream out;
+    return ElfBatch(2).Run(inputs, job, out, err);
+}
+
+/*
+ * A second run over the same directory must only pick up the original
+ * files: not the outputs of the first run, or anything that isn't ELF
+ */
+int Rerun(testLogger& log ) {
+    string dir = "batchRun";
+    mkdir(dir.c_str(), 0777);
+    Copy("isYes/isYes.o", dir + "/isYes.o");
+    Copy("isYes/a.out", dir + "/a.out");
+    Copy("isYes/isYes.c", dir + "/isYes.c");
+
+    for ( int run = 0; run < 2; ++run ) {
+        vector<string> inputs;
+        ostringstream err;
+        size_t failed = Rewrite(dir, inputs, err);
+        log << err.str();
+        if (    failed != 0
+             || inputs.size() != 2
+             || inputs[0] != dir + "/a.out"
+             || inputs[1] != dir + "/isYes.o" )
+        {
+            log << "Run " << run << ": " << inputs.size() << " inputs, "
+                << failed << " failures" << endl;
+            return 1;
+        }
+    }
+
+    // Each input and its output, and nothing else
+    vector<string> files = ElfBatch::Inputs(dir);
+    vector<string> expected = {
+        dir + "/a.out", dir + "/a.out.out",
+        dir + "/isYes.o", dir + "/isYes.o.out"
+    };
+    for ( const string& file: files ) {
+        log << file << endl;
+    }
+    return files == expected ? 0 : 1;
+}
@@ -16,7 +16,7 @@ DataIO outfile(buf,5000000);
 SectionHeader* stringheaders;
 Elf64_Shdr* sections;
 SectionHeader* stringTableHeader;
-std::map<string, int>* sectionMap;
+NameIndex* sectionMap;
 std::vector<Section *>* sectionHeaders;
 
 int ValidHeader(testLogger& log );
@@ -80,21 +80,21 @@ int SectionNames(testLogger& log ) {
     // new string table 
     BinaryReader newSReader(outfile,stringTableHeader->DataStart());
 
-    for ( auto& pair: *sectionMap) {
-        // get the first and second elements
-        string originalName = pair.first;
-        SectionHeader newHdr(sections[pair.second]);
-        Section& oldHdr = *(*sectionHeaders)[pair.second];
+    for ( const NameIndex::Entry& entry: *sectionMap) {
+        // get the name, and the section index
+        string originalName = entry.Name();
+        SectionHeader newHdr(sections[entry.Index()]);
+        Section& oldHdr = *(*sectionHeaders)[entry.Index()];
 
         BinaryReader strTable(outfile,stringTableHeader->DataStart() + newHdr.NameOffset());
         string newName = strTable.ReadString();
         if ( newName != originalName ) {
-            log << "(" << pair.second << ") Name miss match: ";
+            log << "(" << entry.Index() << ") Name miss match: ";
             log  << originalName << " -> " << newName << endl;
             log << hex << oldHdr.DataStart() << " -> " << newHdr.DataStart() << endl;
             return 1;
         } else {
-            log << "(" << pair.second << ") Name match: ";
+            log << "(" << entry.Index() << ") Name match: ";
             log <<  originalName << " -> " << newName << endl;
         }
     }
@@ -0,0 +1,73 @@
+#include "tester.h"
+#include "section.h"
+#include "symbol.h"
+#include <string>
+
+/*
+ * Flag masks are worked out at compile time from the descriptor tables:
+ * check they land where LINK expects them
+ */
+
+using namespace std;
+
+struct TestTraits {
+    static constexpr FlagDescriptor descriptors[] = {
+        { 'X', "First" },
+        { 'Y', "Second" },
+        { 'Z', "Third" }
+    };
+};
+constexpr FlagDescriptor TestTraits::descriptors[];
+typedef FlagSet<TestTraits> TestFlags;
+
+static_assert(TestFlags::COUNT == 3, "Wrong flag count");
+static_assert(TestFlags::Letter('X') == 1, "X should be the first bit");
+static_assert(TestFlags::Letter('Z') == 4, "Z should be the third bit");
+static_assert(TestFlags::Letter('Q') == 0, "Q isn't a flag");
+
+int Letters(testLogger& log );
+int SetAndClear(testLogger& log );
+int Sizes(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("LINK letters are in table order",Letters).RunTest();
+    Test("Setting and clearing flags",SetAndClear).RunTest();
+    Test("Flag sets are just a mask",Sizes).RunTest();
+    return 0;
+}
+
+int Letters(testLogger& log ) {
+    TestFlags flags;
+    // Order of the string doesn't matter: only the table's does
+    flags.SetLetters("ZPX");
+    log << "Mask: " << flags.LinkMask() << endl;
+    if ( flags.LinkMask() != "XZ" ) {
+        return 1;
+    }
+    return 0;
+}
+
+int SetAndClear(testLogger& log ) {
+    TestFlags flags;
+    flags.Set(TestFlags::Letter('Y'));
+    flags.Set(TestFlags::Letter('Z'), true);
+    flags.Set(TestFlags::Letter('Y'), false);
+    if ( flags.Test(TestFlags::Letter('Y')) ||
+        !flags.Test(TestFlags::Letter('Z')) )
+    {
+        log << "Wrong flags: " << flags.LinkMask() << endl;
+        return 1;
+    }
+    if ( flags.Raw() != 4 ) {
+        log << "Wrong mask: " << flags.Raw() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Sizes(testLogger& log ) {
+    log << "Section flags: " << sizeof(SectionFlags) << endl;
+    log << "Symbol flags: " << sizeof(SymbolTypeFlags) << endl;
+    return sizeof(SectionFlags) == sizeof(SectionFlags::Mask) ? 0 : 1;
+}
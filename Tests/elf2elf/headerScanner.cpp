@@ -0,0 +1,142 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "headerScanner.h"
+#include "dataVector.h"
+#include "tester.h"
+#include <cstring>
+#include <string>
+
+/*
+ * The header scanner should see the same tables as the full parser,
+ * without copying them out of a mapped file
+ */
+
+using namespace std;
+
+int Mapped(testLogger& log );
+int Copied(testLogger& log );
+int NotElf(testLogger& log );
+int CheckTables(testLogger& log, ElfHeaderScanner& scan);
+
+int main(int argc, const char *argv[])
+{
+    Test("Scanning a mapped file",Mapped).RunTest();
+    Test("Scanning an in memory copy",Copied).RunTest();
+    Test("Rejecting a file that isn't ELF",NotElf).RunTest();
+    return 0;
+}
+
+int Mapped(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfHeaderScanner scan(f);
+
+    const char* begin = f.Data();
+    const char* end = f.Data() + f.Size();
+    const char* sections = reinterpret_cast<const char*>(&scan.SectionEntry(0));
+    const char* segments = reinterpret_cast<const char*>(&scan.Segment(0));
+    const char* name = scan.SectionName(1).Data();
+    if (    sections < begin || sections >= end
+         || segments < begin || segments >= end
+         || name < begin || name >= end )
+    {
+        log << "Tables were copied out of the mapping" << endl;
+        return 1;
+    }
+    return CheckTables(log, scan);
+}
+
+int Copied(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    DataVector copy(f.Size());
+    copy.Writer().Write(f.Data(), f.Size());
+
+    ElfHeaderScanner scan(copy);
+    return CheckTables(log, scan);
+}
+
+int NotElf(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.c");
+    try {
+        ElfHeaderScanner scan(f);
+    } catch ( const string& error ) {
+        log << "Rejected: " << error << endl;
+        return 0;
+    }
+    log << "A C file was accepted as ELF" << endl;
+    return 1;
+}
+
+/*
+ * Compare the scanner with the parser
+ */
+int CheckTables(testLogger& log, ElfHeaderScanner& scan) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    ElfContent content = p.Content();
+
+    if ( scan.Type() != ET_EXEC && scan.Type() != ET_DYN ) {
+        log << "Unexpected type: " << scan.Type() << endl;
+        return 1;
+    }
+
+    if ( scan.EntryAddress() != content.header.EntryAddress() ) {
+        log << "Entry address missmatch" << endl;
+        return 1;
+    }
+
+    if ( scan.Sections() != content.sections.size() ) {
+        log << "Section count missmatch: " << scan.Sections();
+        log << " , " << content.sections.size() << endl;
+        return 1;
+    }
+
+    for ( size_t i = 0; i < scan.Sections(); ++i ) {
+        Section& sec = *content.sections[i];
+        const Elf64_Shdr& entry = scan.SectionEntry(i);
+        log << "Section " << i << ": " << scan.SectionName(i) << endl;
+        if ( scan.SectionName(i) != sec.NameRef() ) {
+            log << "Name missmatch: " << sec.Name() << endl;
+            return 1;
+        }
+        // The parser has already replaced the section name table
+        bool rewritten = ( i == scan.Header().e_shstrndx );
+        if (   !rewritten 
+             && (    entry.sh_offset != sec.DataStart()
+                  || entry.sh_addr != sec.Address() ) )
+        {
+            log << "Header missmatch" << endl;
+            return 1;
+        }
+        if ( !sec.NameRef().Empty() &&
+             scan.FindSection(sec.NameRef()) != (long)i )
+        {
+            log << "Find returned " << scan.FindSection(sec.NameRef()) << endl;
+            return 1;
+        }
+    }
+
+    if ( scan.Segments() != content.progHeaders.size() ) {
+        log << "Segment count missmatch: " << scan.Segments();
+        log << " , " << content.progHeaders.size() << endl;
+        return 1;
+    }
+
+    for ( size_t i = 0; i < scan.Segments(); ++i ) {
+        const Elf64_Phdr& seg = scan.Segment(i);
+        ProgramHeader& ph = *content.progHeaders[i];
+        if (    (seg.p_type == PT_LOAD) != ph.IsLoadableSegment()
+             || seg.p_vaddr != ph.Address()
+             || seg.p_memsz != ph.SizeInMemory() )
+        {
+            log << "Segment " << i << " missmatch" << endl;
+            return 1;
+        }
+    }
+
+    if ( !scan.HasSection(".text") || scan.HasSection(".no_such_section") ) {
+        log << "HasSection is wrong" << endl;
+        return 1;
+    }
+
+    return 0;
+}
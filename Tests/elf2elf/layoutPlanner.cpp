@@ -0,0 +1,162 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "buildElf.h"
+#include "headerScanner.h"
+#include "dataVector.h"
+#include "tester.h"
+#include <elf.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*
+ * Check the layout ElfFile picks for the files it writes, by reading back
+ * the headers of the output
+ */
+
+using namespace std;
+
+int Congruent(testLogger& log );
+int ObjectFile(testLogger& log );
+int NoWaste(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Segments are placed congruent to their address",Congruent).RunTest();
+    Test("Object file sections don't overlap the header",ObjectFile).RunTest();
+    Test("No more padding than the input",NoWaste).RunTest();
+    return 0;
+}
+
+int Congruent(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    ElfFile file(p.Content());
+    DataVector image;
+    file.WriteToFile(image.Writer());
+
+    ElfHeaderScanner out(image);
+    Elf64_Off lastEnd = 0;
+    for ( size_t i = 0; i < out.Segments(); ++i ) {
+        const Elf64_Phdr& seg = out.Segment(i);
+        if ( seg.p_type != PT_LOAD ) {
+            continue;
+        }
+        log << hex << seg.p_vaddr << " -> " << seg.p_offset << dec << endl;
+        if ( seg.p_offset % seg.p_align != seg.p_vaddr % seg.p_align ) {
+            log << "Segment isn't congruent" << endl;
+            return 1;
+        }
+        if ( seg.p_offset < lastEnd ) {
+            log << "Segment overlaps the one before" << endl;
+            return 1;
+        }
+        lastEnd = seg.p_offset + seg.p_filesz;
+    }
+
+    // Nothing to stop ld's layout being reproduced exactly
+    ElfHeaderScanner in(f);
+    for ( size_t i = 0; i < in.Segments(); ++i ) {
+        if ( in.Segment(i).p_type == PT_LOAD ) {
+            bool found = false;
+            for ( size_t j = 0; j < out.Segments(); ++j ) {
+                found |= (    out.Segment(j).p_vaddr == in.Segment(i).p_vaddr
+                           && out.Segment(j).p_offset == in.Segment(i).p_offset );
+            }
+            if ( !found ) {
+                log << "Segment at " << hex << in.Segment(i).p_vaddr
+                    << " moved" << dec << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int ObjectFile(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    ElfParser p(f);
+    ElfFile file(p.Content());
+    DataVector image;
+    file.WriteToFile(image.Writer());
+
+    ElfHeaderScanner out(image);
+    if ( out.Header().e_shoff % alignof(Elf64_Shdr) != 0 ) {
+        log << "Section table is mis-aligned" << endl;
+        return 1;
+    }
+    for ( size_t i = 1; i < out.Sections(); ++i ) {
+        const Elf64_Shdr& sec = out.SectionEntry(i);
+        if ( sec.sh_type == SHT_NOBITS || sec.sh_size == 0 ) {
+            continue;
+        }
+        if ( sec.sh_offset < sizeof(Elf64_Ehdr) ) {
+            log << out.SectionName(i).ToString() << " is inside the header"
+                << endl;
+            return 1;
+        }
+        if ( sec.sh_addralign > 1 && sec.sh_offset % sec.sh_addralign ) {
+            log << out.SectionName(i).ToString() << " is mis-aligned"
+                << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Bytes of the file at f not covered by the headers, the section table or
+ * any section's data
+ */
+Elf64_Off Padding(const FileLikeReader& f) {
+    ElfHeaderScanner scan(f);
+    const Elf64_Ehdr& header = scan.Header();
+
+    vector<pair<Elf64_Off, Elf64_Off> > used;
+    used.push_back(make_pair((Elf64_Off)0, (Elf64_Off)header.e_ehsize));
+    used.push_back(make_pair(header.e_phoff,
+                             header.e_phoff + header.e_phnum * header.e_phentsize));
+    used.push_back(make_pair(header.e_shoff,
+                             header.e_shoff + header.e_shnum * header.e_shentsize));
+    for ( size_t i = 0; i < scan.Sections(); ++i ) {
+        const Elf64_Shdr& sec = scan.SectionEntry(i);
+        if ( sec.sh_type != SHT_NOBITS ) {
+            used.push_back(make_pair(sec.sh_offset, sec.sh_offset + sec.sh_size));
+        }
+    }
+    sort(used.begin(), used.end());
+
+    Elf64_Off covered = 0;
+    Elf64_Off reached = 0;
+    for ( auto& range : used ) {
+        Elf64_Off start = max(range.first, reached);
+        Elf64_Off end = min<Elf64_Off>(range.second, f.Size());
+        if ( end > start ) {
+            covered += end - start;
+            reached = end;
+        }
+    }
+    return f.Size() - covered;
+}
+
+int NoWaste(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    ElfFile file(p.Content());
+
+    DataVector image;
+    file.WriteToFile(image.Writer());
+
+    Elf64_Off input = Padding(f);
+    log << "Wasted " << file.WastedBytes() << " of " << file.Size()
+        << ", the input wasted " << input << " of " << f.Size() << endl;
+    if ( file.WastedBytes() != Padding(image) ) {
+        log << "WastedBytes doesn't match the output" << endl;
+        return 1;
+    }
+    if ( file.WastedBytes() > input ) {
+        log << "More padding than the input" << endl;
+        return 1;
+    }
+    return 0;
+}
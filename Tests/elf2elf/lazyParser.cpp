@@ -0,0 +1,115 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include <iostream>
+#include "buildElf.h"
+#include "tester.h"
+#include <string>
+
+/*
+ * A lazy parser should look exactly the same from the outside as one that
+ * reads everything up front
+ */
+
+using namespace std;
+
+int Counts(testLogger& log );
+int Link(testLogger& log );
+int Content(testLogger& log );
+
+ElfParserOptions lazyOptions;
+
+int main(int argc, const char *argv[])
+{
+    lazyOptions.lazy = true;
+
+    Test("Comparing header level properties",Counts).RunTest();
+    Test("Comparing LINK output",Link).RunTest();
+    Test("Comparing parsed content",Content).RunTest();
+    return 0;
+}
+
+int Counts(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser eager(f);
+    ElfParser lazy(f, lazyOptions);
+
+    if ( eager.SegmentCount() != lazy.SegmentCount() ) {
+        log << "Segment count missmatch: ";
+        log << eager.SegmentCount() << " , " << lazy.SegmentCount() << endl;
+        return 1;
+    }
+
+    if ( eager.LinkSections() != lazy.LinkSections() ) {
+        log << "Link section missmatch: ";
+        log << eager.LinkSections() << " , " << lazy.LinkSections() << endl;
+        return 1;
+    }
+
+    if ( eager.SymbolCount() != lazy.SymbolCount() ) {
+        log << "Symbol count missmatch: ";
+        log << eager.SymbolCount() << " , " << lazy.SymbolCount() << endl;
+        return 1;
+    }
+
+    if ( eager.LinkSymbols() != lazy.LinkSymbols() ) {
+        log << "Link symbol missmatch: ";
+        log << eager.LinkSymbols() << " , " << lazy.LinkSymbols() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Link(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser eager(f);
+    ElfParser lazy(f, lazyOptions);
+
+    if ( eager.PrintLink() != lazy.PrintLink() ) {
+        log << "LINK output differs!" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Content(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser eager(f);
+    ElfParser lazy(f, lazyOptions);
+
+    ElfContent eagerContent = eager.Content();
+    ElfContent lazyContent = lazy.Content();
+
+    if ( eagerContent.progHeaders.size() != lazyContent.progHeaders.size() ) {
+        log << "Program header count missmatch" << endl;
+        return 1;
+    }
+
+    if ( eagerContent.symbols.size() != lazyContent.symbols.size() ) {
+        log << "Symbol count missmatch" << endl;
+        return 1;
+    }
+
+    for ( size_t i=0; i< eagerContent.symbols.size(); i++ ) {
+        Symbol& lhs = *eagerContent.symbols[i];
+        Symbol& rhs = *lazyContent.symbols[i];
+        if ( lhs.Name() != rhs.Name() || lhs.Value() != rhs.Value() ) {
+            log << "Symbol missmatch: " << i << endl;
+            log << lhs.Name() << " , " << rhs.Name() << endl;
+            return 1;
+        }
+    }
+
+    for ( size_t i=0; i< eagerContent.sections.size(); i++ ) {
+        Section& lhs = *eagerContent.sections[i];
+        Section& rhs = *lazyContent.sections[i];
+        if (    lhs.NameOffset() != rhs.NameOffset() 
+             || lhs.DataSize() != rhs.DataSize() ) 
+        {
+            log << "Section missmatch: " << i << endl;
+            log << lhs.Descripe() << endl;
+            log << rhs.Descripe() << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
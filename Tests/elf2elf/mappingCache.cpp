@@ -0,0 +1,137 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "mappingCache.h"
+#include <iostream>
+#include "tester.h"
+#include <string>
+#include <fstream>
+#include <unistd.h>
+
+/*
+ * Check that files are only mapped once, and that changed files and the
+ * byte limit are respected
+ */
+
+using namespace std;
+
+int Shared(testLogger& log );
+int Reader(testLogger& log );
+int Limit(testLogger& log );
+int Modified(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("The same file shares a mapping",Shared).RunTest();
+    Test("Cached readers parse the same file",Reader).RunTest();
+    Test("Least recently used files are evicted",Limit).RunTest();
+    Test("Modified files are re-mapped",Modified).RunTest();
+    return 0;
+}
+
+int Shared(testLogger& log ) {
+    MappingCache cache;
+    shared_ptr<const ElfMapping> first = cache.Open("isYes/a.out");
+    shared_ptr<const ElfMapping> second = cache.Open("./isYes/../isYes/a.out");
+
+    if ( first.get() != second.get() ) {
+        log << "The file was mapped twice!" << endl;
+        return 1;
+    }
+
+    if ( cache.Entries() != 1 || (long)cache.MappedBytes() != first->Size() ) {
+        log << "Unexpected cache size: " << cache.Entries() << " , ";
+        log << cache.MappedBytes() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Reader(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfFileReader cached("isYes/a.out", ElfFileReader::READ_CACHED);
+    ElfFileReader cached2("isYes/a.out", ElfFileReader::READ_CACHED);
+
+    ElfParser expected(f);
+    ElfParser p(cached);
+
+    if ( expected.PrintLink() != p.PrintLink() ) {
+        log << "LINK output differs!" << endl;
+        return 1;
+    }
+
+    if ( cached.Size() != f.Size() || cached2.Size() != f.Size() ) {
+        log << "Size missmatch: " << cached.Size() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Limit(testLogger& log ) {
+    MappingCache cache;
+    shared_ptr<const ElfMapping> exe = cache.Open("isYes/a.out");
+    shared_ptr<const ElfMapping> obj = cache.Open("isYes/isYes.o");
+
+    // Make room for only one: the least recently used (a.out) should go
+    cache.SetLimit(exe->Size() > obj->Size() ? exe->Size() : obj->Size());
+    cache.Open("isYes/isYes.o");
+    cache.SetLimit(obj->Size());
+
+    if ( cache.Entries() != 1 || (long)cache.MappedBytes() != obj->Size() ) {
+        log << "Expected only isYes.o to be left, got " << cache.Entries();
+        log << " entries (" << cache.MappedBytes() << " bytes)" << endl;
+        return 1;
+    }
+
+    if ( cache.Open("isYes/isYes.o").get() != obj.get() ) {
+        log << "The most recent mapping was evicted" << endl;
+        return 1;
+    }
+
+    // The evicted mapping is still usable
+    if ( exe->Data()[1] != 'E' ) {
+        log << "Evicted mapping is no longer valid" << endl;
+        return 1;
+    }
+
+    // And asking again re-maps it
+    if ( cache.Open("isYes/a.out").get() == exe.get() ) {
+        log << "Evicted mapping was handed out" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Modified(testLogger& log ) {
+    const char* path = "mappingCache.tmp";
+    {
+        ofstream out(path);
+        out << "version one";
+    }
+
+    MappingCache cache;
+    shared_ptr<const ElfMapping> before = cache.Open(path);
+
+    {
+        ofstream out(path);
+        out << "version two, which is longer";
+    }
+
+    shared_ptr<const ElfMapping> after = cache.Open(path);
+    unlink(path);
+
+    if ( after.get() == before.get() ) {
+        log << "Stale mapping returned" << endl;
+        return 1;
+    }
+
+    if ( string(after->Data(), after->Size()) != "version two, which is longer" ) {
+        log << "Unexpected content: " << string(after->Data(), after->Size()) << endl;
+        return 1;
+    }
+
+    if ( cache.Entries() != 1 ) {
+        log << "Stale mapping was kept in the cache" << endl;
+        return 1;
+    }
+    return 0;
+}
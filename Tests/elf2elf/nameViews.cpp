@@ -0,0 +1,85 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "streamReader.h"
+#include <iostream>
+#include "buildElf.h"
+#include "tester.h"
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Section and symbol names are views into the string tables: check they
+ * say the same thing as the tables themselves
+ */
+
+using namespace std;
+
+int Mapped(testLogger& log );
+int Copied(testLogger& log );
+int CheckNames(testLogger& log, ElfParser& p);
+
+int main(int argc, const char *argv[])
+{
+    Test("Names from a mapped file",Mapped).RunTest();
+    Test("Names from a stream",Copied).RunTest();
+    return 0;
+}
+
+int Mapped(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+
+    // No copies: every name should point into the mapping
+    ElfContent content = p.Content();
+    for ( Symbol* sym: content.symbols ) {
+        const char* name = sym->NameRef().Data();
+        if ( !sym->NameRef().Empty() && 
+             (name < f.Data() || name >= f.Data() + f.Size()) ) 
+        {
+            log << "Name of " << sym->Name() << " is not in the file" << endl;
+            return 1;
+        }
+    }
+    return CheckNames(log, p);
+}
+
+int Copied(testLogger& log ) {
+    int fd = open("isYes/a.out", O_RDONLY);
+    StreamReader stream(fd);
+    ElfParser p(stream);
+    int result = CheckNames(log, p);
+    close(fd);
+    return result;
+}
+
+/*
+ * The views should match the names read back through the (copying) 
+ * string accessors
+ */
+int CheckNames(testLogger& log, ElfParser& p) {
+    ElfContent content = p.Content();
+
+    for ( Section* sec: content.sections ) {
+        string name = sec->Name();
+        if ( sec->NameRef() != name.c_str() || sec->NameRef() != NameView(name) ) {
+            log << "View and name differ: " << sec->NameRef() << " , " << name << endl;
+            return 1;
+        }
+        if ( !name.empty() && content.sectionMap.Find(sec->NameRef()) == NameIndex::NOT_FOUND ) {
+            log << "Section " << name << " is not in the index" << endl;
+            return 1;
+        }
+    }
+
+    const SymbolTable& columns = p.Symbols();
+    for ( size_t i=0; i < content.symbols.size(); ++i ) {
+        Symbol& sym = *content.symbols[i];
+        string expected = columns.Name(i);
+        if ( sym.NameRef() != NameView(expected) ) {
+            log << "Symbol " << i << ": " << sym.NameRef() << " , " << expected << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
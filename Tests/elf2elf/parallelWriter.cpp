@@ -0,0 +1,92 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "buildElf.h"
+#include "blockCopy.h"
+#include "tester.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Writing a file with several threads must give exactly the same bytes
+ * as writing it with one
+ */
+
+using namespace std;
+
+int Streaming(testLogger& log );
+int SmallFile(testLogger& log );
+int BigSection(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Non-temporal copies",Streaming).RunTest();
+    Test("A file too small to share out",SmallFile).RunTest();
+    Test("A file with a large section",BigSection).RunTest();
+    return 0;
+}
+
+string ReadBack(const string& path) {
+    ifstream in(path.c_str(), ios::binary);
+    stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+int Streaming(testLogger& log ) {
+    // Odd sizes and offsets, to exercise the unaligned head and tail
+    size_t size = STREAMING_COPY_MIN + 77;
+    vector<char> src(size + 3);
+    for ( size_t i = 0; i < src.size(); ++i ) {
+        src[i] = (char)(i * 31);
+    }
+    vector<char> dest(size + 5, 0);
+    BlockCopy(dest.data() + 5, src.data() + 3, size);
+
+    if ( !equal(src.begin() + 3, src.end(), dest.begin() + 5) ) {
+        log << "Copy differs" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Compare(testLogger& log, ElfFile& file) {
+    file.WriteToFile("/tmp/parallelWriter.1", 1);
+    file.WriteToFile("/tmp/parallelWriter.8", 8);
+    string serial = ReadBack("/tmp/parallelWriter.1");
+    string parallel = ReadBack("/tmp/parallelWriter.8");
+    log << "Wrote " << serial.size() << " bytes" << endl;
+    if ( serial.size() != file.Size() || serial != parallel ) {
+        log << "Output differs" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int SmallFile(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    ElfFile file(p.Content());
+    return Compare(log, file);
+}
+
+int BigSection(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    ElfContent content = p.Content();
+
+    // Grow .comment (which gets tacked on the end) to 40MB
+    Section& comment = *content.GetSection(".comment");
+    shared_ptr<Data> data = comment.GetData();
+    long size = 40 * 1024 * 1024;
+    data->Resize(size);
+    for ( long i = 0; i < size; i += 4096 ) {
+        BinaryWriter w(*data, i);
+        w << i;
+    }
+    comment.DataSize() = size;
+
+    ElfFile file(content);
+    return Compare(log, file);
+}
@@ -0,0 +1,212 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "streamReader.h"
+#include "relocationStore.h"
+#include "dataVector.h"
+#include "tester.h"
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * The parser copies every SHT_RELA entry into a single store: check
+ * against what readelf -r says about isYes.o
+ */
+
+using namespace std;
+
+int ObjectFile(testLogger& log );
+int BySymbol(testLogger& log );
+int Grouping(testLogger& log );
+int Streamed(testLogger& log );
+int LinkOutput(testLogger& log );
+int Executable(testLogger& log );
+int UnknownType(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Reading isYes.o's relocations",ObjectFile).RunTest();
+    Test("Finding relocations by symbol",BySymbol).RunTest();
+    Test("Tables are grouped by target section",Grouping).RunTest();
+    Test("Relocations from a stream",Streamed).RunTest();
+    Test("Relocations in isYes.o's LINK output",LinkOutput).RunTest();
+    Test("No LINK relocations for dynamic symbols",Executable).RunTest();
+    Test("Writing a type we don't know",UnknownType).RunTest();
+    return 0;
+}
+
+int ObjectFile(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    ElfParser p(f);
+    const RelocationStore& relocs = p.Relocations();
+
+    if ( p.RelocCount() != 3 || relocs.Size() != 3 ) {
+        log << "Expected 3 relocations, got " << relocs.Size() << endl;
+        return 1;
+    }
+
+    // .rela.text: a call to isYes
+    int text = p.Content().sectionMap.Find(".text");
+    RelocationStore::Range range = relocs.ForSection(text);
+    if ( range.Size() != 1 ) {
+        log << ".text has " << range.Size() << " relocations" << endl;
+        return 1;
+    }
+    const Elf64_Rela& call = *range.Begin();
+    log << Relocation::LinkFormat(call, text, ELF64_R_SYM(call.r_info)) << endl;
+    if (    ELF64_R_TYPE(call.r_info) != R_X86_64_PC32
+         || call.r_addend != -4 )
+    {
+        return 1;
+    }
+
+    // .rela.eh_frame: two references to .text
+    int frame = p.Content().sectionMap.Find(".eh_frame");
+    range = relocs.ForSection(frame);
+    if ( range.Size() != 2 || relocs.TargetSection(2) != (Elf64_Word)frame ) {
+        log << ".eh_frame has " << range.Size() << " relocations" << endl;
+        return 1;
+    }
+
+    if ( relocs.ForSection(frame + 100).Size() != 0 ) {
+        log << "Relocations for a section that doesn't exist" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int BySymbol(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    ElfParser p(f);
+    const RelocationStore& relocs = p.Relocations();
+
+    size_t total = 0;
+    for ( size_t sym = 0; sym < (size_t)p.SymbolCount(); ++sym ) {
+        RelocationStore::SymbolRange range = relocs.ForSymbol(sym);
+        for ( const uint32_t* i = range.Begin(); i != range.End(); ++i ) {
+            if ( ELF64_R_SYM(relocs[*i].r_info) != sym ) {
+                log << "Relocation " << *i << " isn't against " << sym << endl;
+                return 1;
+            }
+            ++total;
+        }
+    }
+    if ( total != relocs.Size() ) {
+        log << "Only found " << total << " relocations by symbol" << endl;
+        return 1;
+    }
+    return relocs.ForSymbol(10000).Size() == 0 ? 0 : 1;
+}
+
+int Grouping(testLogger& log ) {
+    Elf64_Rela raw[3];
+    for ( int i = 0; i < 3; ++i ) {
+        raw[i].r_offset = i;
+        raw[i].r_info = ELF64_R_INFO(i, R_X86_64_64);
+        raw[i].r_addend = 0;
+    }
+    DataVector file(sizeof(raw));
+    file.Writer().Write(raw, sizeof(raw));
+
+    RelocationStore store;
+    store.Add(BinaryReader(file), 1, 2);
+    store.Add(BinaryReader(file) + sizeof(Elf64_Rela), 2, 2);
+    store.Add(BinaryReader(file), 1, 5);
+
+    if ( store.Sections() != 2 || store.ForSection(2).Size() != 3 ) {
+        log << "Tables for the same section weren't merged" << endl;
+        return 1;
+    }
+
+    try {
+        store.Add(BinaryReader(file), 1, 3);
+    } catch ( string& error ) {
+        log << "Threw: " << error << endl;
+        return 0;
+    }
+    log << "Adding out of order should have failed" << endl;
+    return 1;
+}
+
+int Streamed(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    ElfParser mapped(f);
+    string expected = mapped.PrintLink();
+
+    int fd = open("isYes/isYes.o", O_RDONLY);
+    StreamReader stream(fd);
+    ElfParserOptions options;
+    options.lazy = true;
+    ElfParser streamed(stream, options);
+    string link = streamed.PrintLink();
+    close(fd);
+
+    if ( link != expected ) {
+        log << link << endl << " != " << endl << expected << endl;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * The number of relocations in the LINK header, and the lines written
+ * under "# Relocations"
+ */
+size_t LinkRelocations(const string& link, vector<string>& lines) {
+    istringstream in(link);
+    string line;
+    size_t nsegs = 0, nsyms = 0, nrels = 0;
+    while ( getline(in, line) && line != "# Header: nsegs, nsyms, nrels flags" ) {
+    }
+    in >> nsegs >> nsyms >> nrels;
+    while ( getline(in, line) && line != "# Relocations" ) {
+    }
+    while ( getline(in, line) && line != "# section data" ) {
+        lines.push_back(line);
+    }
+    return nrels;
+}
+
+int LinkOutput(testLogger& log ) {
+    ElfFileReader f("isYes/isYes.o");
+    ElfParser p(f);
+    vector<string> lines;
+    size_t nrels = LinkRelocations(p.PrintLink(), lines);
+    for ( const string& line: lines ) {
+        log << line << endl;
+    }
+
+    // The call from main (in segment 1, .text) to isYes (the 2nd symbol).
+    // The .eh_frame entries are against a section symbol, which LINK
+    // doesn't write
+    if (    nrels != 1 
+         || nrels != lines.size() 
+         || (int)nrels != p.LinkRelocations() )
+    {
+        log << "Header says " << nrels << " relocations" << endl;
+        return 1;
+    }
+    return lines[0] == "46 1 2 RS4+ -4" ? 0 : 1;
+}
+
+int Executable(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    vector<string> lines;
+    size_t nrels = LinkRelocations(p.PrintLink(), lines);
+    log << nrels << " of " << p.RelocCount() << " relocations written" << endl;
+    return nrels == 0 && lines.empty() ? 0 : 1;
+}
+
+int UnknownType(testLogger& log ) {
+    Elf64_Rela rela;
+    rela.r_offset = 0x10;
+    rela.r_info = ELF64_R_INFO(3, 42);
+    rela.r_addend = 0;
+    string line = Relocation::LinkFormat(rela, 1, 2);
+    log << line << endl;
+    return line == "10 1 2 UNKNOWN(42)" ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include "tester.h"
+#include "reloc.h"
+#include "dataVector.h"
+#include "binaryReader.h"
+#include <elf.h>
+#include <string>
+
+/*
+ * Relocations are decoded from a table, rather than a switch
+ */
+
+using namespace std;
+
+int Table(testLogger& log );
+int Supported(testLogger& log );
+int Unsupported(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Every type is in the table",Table).RunTest();
+    Test("Decoding a supported relocation",Supported).RunTest();
+    Test("Decoding relocations we can't handle",Unsupported).RunTest();
+    return 0;
+}
+
+/*
+ * A relocation of type against symbol 1, with an addend of -4
+ */
+Relocation Make(DataVector& file, Elf64_Xword type) {
+    Elf64_Rela raw;
+    raw.r_offset = 0x10;
+    raw.r_info = ELF64_R_INFO(1, type);
+    raw.r_addend = -4;
+    file.Resize(sizeof(raw));
+    file.Writer().Write(&raw, sizeof(raw));
+    return Relocation(BinaryReader(file), ".text");
+}
+
+int Table(testLogger& log ) {
+    for ( Elf64_Xword type = 0; type < X86RelocationTable::COUNT; ++type ) {
+        const RelocationKind& kind = X86RelocationTable::Find(type);
+        log << type << ": " << kind.name << endl;
+        if ( kind.type != type || kind.support == RelocationKind::UNKNOWN ) {
+            return 1;
+        }
+    }
+    const RelocationKind& past = X86RelocationTable::Find(R_X86_64_NUM + 5);
+    if ( past.support != RelocationKind::UNKNOWN ) {
+        log << "Unexpected kind: " << past.name << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int Supported(testLogger& log ) {
+    DataVector file;
+    Relocation reloc = Make(file, R_X86_64_32S);
+    if ( reloc.Decode() != RelocationKind::SUPPORTED ) {
+        log << "R_X86_64_32S wasn't decoded" << endl;
+        return 1;
+    }
+
+    log << reloc.TypeName() << ": " << reloc.Flags().LinkMask() << endl;
+    if ( string(reloc.TypeName()) != "R_X86_64_32S" ||
+         reloc.Addend() != -4 ||
+         reloc.Kind().width != 4 ||
+         reloc.Kind().pcRelative ||
+         reloc.Flags().LinkMask() != "AS4I" )
+    {
+        return 1;
+    }
+
+    Relocation pc = Make(file, R_X86_64_PC16);
+    pc.ConvertFromElf();
+    log << pc.TypeName() << ": " << pc.Flags().LinkMask() << endl;
+    if ( pc.Flags().LinkMask() != "RS2I" ) {
+        return 1;
+    }
+    return 0;
+}
+
+int Unsupported(testLogger& log ) {
+    DataVector file;
+    Relocation plt = Make(file, R_X86_64_PLT32);
+    if (    plt.Decode() != RelocationKind::UNSUPPORTED
+         || plt.Flags().LinkMask() != "" )
+    {
+        log << "PLT32 should be unsupported" << endl;
+        return 1;
+    }
+
+    Relocation junk = Make(file, 200);
+    if ( junk.Decode() != RelocationKind::UNKNOWN ) {
+        log << "Type 200 should be unknown" << endl;
+        return 1;
+    }
+
+    // The throwing interface still throws
+    try {
+        junk.ConvertFromElf();
+    } catch ( string& error ) {
+        log << "Threw: " << error << endl;
+        return 0;
+    }
+    return 1;
+}
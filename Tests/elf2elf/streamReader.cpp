@@ -0,0 +1,138 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include "streamReader.h"
+#include <iostream>
+#include "buildElf.h"
+#include "tester.h"
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Parsing a file from a pipe should give exactly the same result as
+ * mapping it
+ */
+
+using namespace std;
+
+int PipeLink(testLogger& log );
+int FileContent(testLogger& log );
+int WindowLimit(testLogger& log );
+int Released(testLogger& log );
+
+const vector<string> files = vector<string>({"isYes/a.out", "isYes/isYes.o"});
+
+int main(int argc, const char *argv[])
+{
+    Test("LINK output from a pipe",PipeLink).RunTest();
+    Test("Parsed content from a stream",FileContent).RunTest();
+    Test("The window limit is enforced",WindowLimit).RunTest();
+    Test("Released data can't be read",Released).RunTest();
+    return 0;
+}
+
+int PipeLink(testLogger& log ) {
+    ElfParserOptions options;
+    options.lazy = true;
+
+    for ( const string& file: files ) {
+        ElfFileReader f(file);
+        ElfParser expected(f, options);
+
+        FILE* pipe = popen(("cat " + file).c_str(), "r");
+        StreamReader stream(fileno(pipe));
+        ElfParser p(stream, options);
+
+        string expectedLink = expected.PrintLink();
+        string link = p.PrintLink();
+        pclose(pipe);
+
+        log << file << ": peak window " << stream.PeakWindow() << " bytes" << endl;
+        if ( link != expectedLink ) {
+            log << file << ": LINK output differs!" << endl;
+            log << link << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int FileContent(testLogger& log ) {
+    for ( const string& file: files ) {
+        ElfFileReader f(file);
+        ElfParser expected(f);
+
+        int fd = open(file.c_str(), O_RDONLY);
+        StreamReader stream(fd);
+        ElfParser p(stream);
+
+        if ( p.PrintLink() != expected.PrintLink() ) {
+            log << file << ": LINK output differs!" << endl;
+            close(fd);
+            return 1;
+        }
+
+        ElfContent content = p.Content();
+        ElfContent expectedContent = expected.Content();
+        close(fd);
+
+        if ( content.symbols.size() != expectedContent.symbols.size() ) {
+            log << file << ": symbol count missmatch" << endl;
+            return 1;
+        }
+
+        for ( size_t i=0; i < content.symbols.size(); ++i ) {
+            if ( content.symbols[i]->LinkFormat() != 
+                 expectedContent.symbols[i]->LinkFormat() ) 
+            {
+                log << file << ": symbol " << i << " differs" << endl;
+                return 1;
+            }
+        }
+
+        if ( !stream.AtEnd() && stream.Size() < f.Size() ) {
+            log << file << ": only read " << stream.Size() << " of ";
+            log << f.Size() << " bytes" << endl;
+        }
+    }
+    return 0;
+}
+
+int WindowLimit(testLogger& log ) {
+    int fd = open("isYes/a.out", O_RDONLY);
+    StreamReader stream(fd, 1024);
+
+    try {
+        ElfParser p(stream);
+        log << "Parsed with a 1KiB window!" << endl;
+        close(fd);
+        return 1;
+    } catch ( string& err ) {
+        log << "Caught: " << err << endl;
+    }
+    close(fd);
+    return 0;
+}
+
+int Released(testLogger& log ) {
+    ElfParserOptions options;
+    options.lazy = true;
+
+    int fd = open("isYes/a.out", O_RDONLY);
+    StreamReader stream(fd);
+    ElfParser p(stream, options);
+    p.PrintLink();
+
+    try {
+        // The ELF header isn't needed once parsed
+        stream.Get(1);
+        log << "Read released data!" << endl;
+        close(fd);
+        return 1;
+    } catch ( string& err ) {
+        log << "Caught: " << err << endl;
+    }
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "elfParser.h"
+#include "elfReader.h"
+#include <iostream>
+#include "buildElf.h"
+#include "tester.h"
+#include <string>
+#include <algorithm>
+
+/*
+ * The column-wise symbol table must describe exactly the same symbols as
+ * the parsed Symbol objects
+ */
+
+using namespace std;
+
+int Fields(testLogger& log );
+int Filters(testLogger& log );
+int Ranges(testLogger& log );
+
+int main(int argc, const char *argv[])
+{
+    Test("Comparing symbol fields",Fields).RunTest();
+    Test("Comparing link symbol and type filters",Filters).RunTest();
+    Test("Checking address range queries",Ranges).RunTest();
+    return 0;
+}
+
+int Fields(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    const SymbolTable& table = p.Symbols();
+    ElfContent content = p.Content();
+
+    if ( table.Size() != content.symbols.size() ) {
+        log << "Size missmatch: " << table.Size() << " , ";
+        log << content.symbols.size() << endl;
+        return 1;
+    }
+
+    for ( size_t i=0; i < table.Size(); ++i ) {
+        Symbol& sym = *content.symbols[i];
+        if ( table.Name(i) != sym.Name() ) {
+            log << "Name missmatch at " << i << ": " << table.Name(i);
+            log << " , " << sym.Name() << endl;
+            return 1;
+        }
+        if ( table.IsLinkSymbol(i) != sym.IsLinkSymbol() ) {
+            log << "Link missmatch for " << sym.Name() << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int Filters(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    const SymbolTable& table = p.Symbols();
+
+    vector<size_t> links = table.LinkSymbols();
+    if ( (int)links.size() != p.LinkSymbols() || 
+         table.CountLinkSymbols() != links.size() ) 
+    {
+        log << "Link symbol count missmatch: " << links.size() << " , ";
+        log << p.LinkSymbols() << endl;
+        return 1;
+    }
+
+    size_t total = 0;
+    for ( unsigned char type = 0; type < 16; ++type ) {
+        vector<size_t> matches = table.OfType(type);
+        for ( size_t i: matches ) {
+            if ( table.Type(i) != type ) {
+                log << "Symbol " << i << " is not of type " << (int)type << endl;
+                return 1;
+            }
+        }
+        total += matches.size();
+    }
+
+    if ( total != table.Size() ) {
+        log << "Type filters found " << total << " of " << table.Size() << endl;
+        return 1;
+    }
+
+    vector<size_t> globals = table.WithBinding(STB_GLOBAL);
+    for ( size_t i: globals ) {
+        if ( table.Binding(i) != STB_GLOBAL ) {
+            log << "Symbol " << i << " is not global" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int Ranges(testLogger& log ) {
+    ElfFileReader f("isYes/a.out");
+    ElfParser p(f);
+    const SymbolTable& table = p.Symbols();
+
+    if ( table.Size() == 0 ) {
+        log << "No symbols to search!" << endl;
+        return 1;
+    }
+
+    // Check the index against a brute force search, for a window around
+    // each symbol
+    for ( size_t s=0; s < table.Size(); ++s ) {
+        Elf64_Addr start = table.Value(s);
+        Elf64_Addr end = start + 0x100;
+
+        vector<size_t> expected;
+        for ( size_t i=0; i < table.Size(); ++i ) {
+            if ( table.Value(i) >= start && table.Value(i) < end ) {
+                expected.push_back(i);
+            }
+        }
+
+        vector<size_t> found = table.InRange(start,end);
+        if ( found.size() != expected.size() ) {
+            log << "Expected " << expected.size() << " symbols in range ";
+            log << start << " , " << end << " but got " << found.size() << endl;
+            return 1;
+        }
+
+        for ( size_t i=1; i < found.size(); ++i ) {
+            if ( table.Value(found[i-1]) > table.Value(found[i]) ) {
+                log << "Range result is not sorted!" << endl;
+                return 1;
+            }
+        }
+
+        sort(found.begin(), found.end());
+        if ( found != expected ) {
+            log << "Range results differ for " << start << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+/*
+ * Compare the ElfFileReader access hints, parsing a large synthetic object
+ * file from a cold page cache, and then again once it is in memory.
+ *
+ * The parse and rewrite throughput is then measured for normal and huge
+ * page backed inputs.
+ *
+ * The page cache is emptied with posix_fadvise(DONTNEED), which the kernel
+ * is free to ignore, so cold numbers are only as cold as it allows.
+ *
+ * Usage: readerSpeed [# symbols]
+ */
+#include "elfParser.h"
+#include "elfReader.h"
+#include "tester.h"
+#include "dataVector.h"
+#include "binaryWriter.h"
+#include "buildElf.h"
+#include "stdWriter.h"
+#include <elf.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+long symbolCount = 1000000;
+const string fileName = "readerSpeed.o";
+
+struct Hint {
+    const char* name;
+    int hints;
+};
+
+const vector<Hint> hints = vector<Hint>({
+    {"default", ElfFileReader::READ_DEFAULT},
+    {"sequential", ElfFileReader::READ_SEQUENTIAL},
+    {"random", ElfFileReader::READ_RANDOM},
+    {"populate", ElfFileReader::READ_POPULATE},
+    {"huge pages", ElfFileReader::READ_HUGE_PAGES},
+    {"staged huge pages", ElfFileReader::READ_STAGE_HUGE_PAGES}
+});
+
+void BuildFile(DataVector& file, long count);
+void WriteFile(DataVector& file, const string& path);
+void DropCache(const string& path);
+double TimeParse(int hints);
+void TimeRewrite(int hints, double& parse, double& rewrite);
+int SameContent(testLogger& log);
+int PrefetchBounds(testLogger& log);
+
+int main(int argc, const char *argv[])
+{
+    if ( argc > 1 ) {
+        symbolCount = atol(argv[1]);
+    }
+
+    {
+        DataVector file;
+        BuildFile(file,symbolCount);
+        WriteFile(file,fileName);
+    }
+
+    Test("Every hint reads the same file",SameContent).RunTest();
+    Test("Prefetch is clamped to the file",PrefetchBounds).RunTest();
+
+    cout << "Parsing " << symbolCount << " symbols" << endl;
+    for ( const Hint& hint: hints ) {
+        DropCache(fileName);
+        double cold = TimeParse(hint.hints);
+        double warm = TimeParse(hint.hints);
+        cout << "  " << hint.name << ": cold " << cold << "s, warm ";
+        cout << warm << "s" << endl;
+    }
+
+    long size = ElfFileReader(fileName).Size();
+    double mb = size / (1024.0 * 1024.0);
+    cout << "Parse / rewrite throughput (" << mb << "MiB, warm cache)" << endl;
+    for ( const Hint& hint: hints ) {
+        double parse = 0, rewrite = 0;
+        TimeRewrite(hint.hints, parse, rewrite);
+        cout << "  " << hint.name << ": parse " << mb / parse << "MiB/s, ";
+        cout << "rewrite " << mb / rewrite << "MiB/s" << endl;
+    }
+
+    unlink(fileName.c_str());
+    unlink((fileName + ".out").c_str());
+    return 0;
+}
+
+double TimeParse(int hints) {
+    auto start = chrono::steady_clock::now();
+    ElfFileReader f(fileName, hints);
+    ElfParser p(f);
+    p.SymbolCount();
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double>(end - start).count();
+}
+
+/*
+ * Time a full parse (everything elf2elf needs), and then writing the file
+ * back out
+ */
+void TimeRewrite(int hints, double& parse, double& rewrite) {
+    auto start = chrono::steady_clock::now();
+    ElfFileReader f(fileName, hints);
+    ElfParser p(f);
+    ElfContent content = p.Content();
+    auto parsed = chrono::steady_clock::now();
+
+    {
+        OFStreamWriter of((fileName + ".out").c_str());
+        ElfFile file(content);
+        file.WriteToFile(of);
+    }
+    auto end = chrono::steady_clock::now();
+
+    parse = chrono::duration<double>(parsed - start).count();
+    rewrite = chrono::duration<double>(end - parsed).count();
+}
+
+int SameContent(testLogger& log) {
+    ElfFileReader expectedFile(fileName);
+    ElfParser expected(expectedFile);
+
+    for ( const Hint& hint: hints ) {
+        ElfFileReader f(fileName, hint.hints);
+        ElfParser p(f);
+
+        if ( f.Size() != expectedFile.Size() ) {
+            log << hint.name << ": size missmatch: " << f.Size() << endl;
+            return 1;
+        }
+
+        for ( long i = 0; i < f.Size(); i += 4093 ) {
+            if ( f.Get(i) != expectedFile.Get(i) ) {
+                log << hint.name << ": data missmatch at " << i << endl;
+                return 1;
+            }
+        }
+
+        if (    p.SymbolCount() != expected.SymbolCount() 
+             || p.LinkSymbols() != expected.LinkSymbols() )
+        {
+            log << hint.name << ": symbol count missmatch: ";
+            log << p.SymbolCount() << " , " << expected.SymbolCount() << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int PrefetchBounds(testLogger& log) {
+    ElfFileReader f(fileName);
+    long size = f.Size();
+
+    // None of these should fault
+    f.Prefetch(0, size);
+    f.Prefetch(1, 1);
+    f.Prefetch(size - 10, 1000);
+    f.Prefetch(size, 10);
+    f.Prefetch(-5, 10);
+    f.Prefetch(10, -5);
+
+    unsigned char last = f.Get(size - 1);
+    log << "Last byte: " << (int)last << endl;
+    return 0;
+}
+
+void WriteFile(DataVector& file, const string& path) {
+    vector<char> buf(file.Size());
+    BinaryReader(file).Read(&buf[0], buf.size());
+
+    ofstream out(path.c_str(), ios::binary);
+    out.write(&buf[0], buf.size());
+}
+
+void DropCache(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if ( fd >= 0 ) {
+        // Only clean pages can be dropped
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+/*
+ * Build a minimal relocatable object in memory: a large .symtab, its
+ * .strtab, and .shstrtab.
+ */
+void BuildFile(DataVector& file, long count) {
+    const char shstrtab[] = "\0.symtab\0.strtab\0.shstrtab";
+    const long symtabName = 1;
+    const long strtabName = 9;
+    const long shstrtabName = 17;
+
+    string strtab(1,'\0');
+    vector<Elf64_Sym> symbols(count);
+    for ( long i=0; i< count; ++i ) {
+        Elf64_Sym& sym = symbols[i];
+        memset(&sym,0,sizeof(sym));
+        if ( i % 16 != 0 ) {
+            ostringstream name;
+            name << "_ZN9namespace5Class" << i << "methodEv";
+            sym.st_name = strtab.size();
+            strtab += name.str();
+            strtab += '\0';
+        }
+        sym.st_value = 0x400000 + i * 16;
+        sym.st_size = 16;
+        sym.st_info = ELF64_ST_INFO( i % 3 == 0 ? STB_GLOBAL : STB_LOCAL,
+                                     i % 2 == 0 ? STT_FUNC : STT_OBJECT);
+        sym.st_shndx = 1 + i % 3;
+    }
+
+    Elf64_Off symtabStart = sizeof(Elf64_Ehdr);
+    Elf64_Off strtabStart = symtabStart + count * sizeof(Elf64_Sym);
+    Elf64_Off shstrtabStart = strtabStart + strtab.size();
+    Elf64_Off headersStart = shstrtabStart + sizeof(shstrtab);
+    headersStart += 8 - headersStart % 8;
+
+    Elf64_Shdr headers[4];
+    memset(headers,0,sizeof(headers));
+
+    headers[1].sh_name = symtabName;
+    headers[1].sh_type = SHT_SYMTAB;
+    headers[1].sh_offset = symtabStart;
+    headers[1].sh_size = count * sizeof(Elf64_Sym);
+    headers[1].sh_link = 2;
+    headers[1].sh_entsize = sizeof(Elf64_Sym);
+    headers[1].sh_addralign = 8;
+
+    headers[2].sh_name = strtabName;
+    headers[2].sh_type = SHT_STRTAB;
+    headers[2].sh_offset = strtabStart;
+    headers[2].sh_size = strtab.size();
+    headers[2].sh_addralign = 1;
+
+    headers[3].sh_name = shstrtabName;
+    headers[3].sh_type = SHT_STRTAB;
+    headers[3].sh_offset = shstrtabStart;
+    headers[3].sh_size = sizeof(shstrtab);
+    headers[3].sh_addralign = 1;
+
+    ElfHeaderX86_64 header = ElfHeaderX86_64::NewObjectFile();
+    header.Sections() = 4;
+    header.SectionTableStart() = headersStart;
+    header.StringTableIndex() = 3;
+
+    file.Resize(headersStart + sizeof(headers));
+    file.Fill(0,'\0',file.Size());
+
+    BinaryWriter writer = file.Writer();
+    Elf64_Ehdr rawHeader;
+    header.GetHeader(rawHeader);
+    writer.Write(&rawHeader,sizeof(rawHeader));
+
+    (writer + symtabStart).Write(&symbols[0],count * sizeof(Elf64_Sym));
+    (writer + strtabStart).Write(strtab.c_str(),strtab.size());
+    (writer + shstrtabStart).Write(shstrtab,sizeof(shstrtab));
+    (writer + headersStart).Write(headers,sizeof(headers));
+}
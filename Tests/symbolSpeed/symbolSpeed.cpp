@@ -0,0 +1,204 @@
+/*
+ * Compare the serial and multi-threaded symbol table decoders.
+ *
+ * A synthetic object file with a very large symbol table is built in
+ * memory, and then decoded with an increasing number of threads. Every
+ * run must produce exactly the same symbols as the serial decoder.
+ *
+ * Usage: symbolSpeed [# symbols]
+ */
+#include "elfParser.h"
+#include "tester.h"
+#include "dataVector.h"
+#include "binaryWriter.h"
+#include <elf.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+long symbolCount = 1000000;
+DataVector* elfFile = NULL;
+
+void BuildFile(DataVector& file, long count);
+int Compare(testLogger& log);
+double TimeDecode(int threads);
+
+int main(int argc, const char *argv[])
+{
+    if ( argc > 1 ) {
+        symbolCount = atol(argv[1]);
+    }
+
+    DataVector file;
+    BuildFile(file,symbolCount);
+    elfFile = &file;
+
+    Test("Parallel decode matches serial decode",Compare).RunTest();
+
+    int maxThreads = std::thread::hardware_concurrency();
+    if ( maxThreads < 2 ) {
+        maxThreads = 2;
+    }
+
+    cout << "Decoding " << symbolCount << " symbols" << endl;
+    double serial = TimeDecode(1);
+    cout << "  1 thread: " << serial << "s" << endl;
+    for ( int threads = 2; threads <= maxThreads; threads *= 2 ) {
+        double time = TimeDecode(threads);
+        cout << "  " << threads << " threads: " << time << "s";
+        cout << " (x" << serial / time << ")" << endl;
+    }
+    return 0;
+}
+
+double TimeDecode(int threads) {
+    ElfParserOptions options;
+    options.lazy = true;
+    options.symbolThreads = threads;
+
+    auto start = chrono::steady_clock::now();
+    ElfParser p(*elfFile, options);
+    p.SymbolCount();
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double>(end - start).count();
+}
+
+int Compare(testLogger& log) {
+    ElfParserOptions serialOptions;
+    ElfParserOptions parallelOptions;
+    parallelOptions.symbolThreads = 7;
+
+    ElfParser serial(*elfFile, serialOptions);
+    ElfParser parallel(*elfFile, parallelOptions);
+
+    ElfContent lhs = serial.Content();
+    ElfContent rhs = parallel.Content();
+
+    if ( serial.LinkSymbols() != parallel.LinkSymbols() ) {
+        log << "Link symbols missmatch: " << serial.LinkSymbols();
+        log << " , " << parallel.LinkSymbols() << endl;
+        return 1;
+    }
+
+    if ( lhs.symbols.size() != rhs.symbols.size() ) {
+        log << "Symbol count missmatch: " << lhs.symbols.size();
+        log << " , " << rhs.symbols.size() << endl;
+        return 1;
+    }
+
+    for ( size_t i=0; i< lhs.symbols.size(); i++ ) {
+        Symbol& l = *lhs.symbols[i];
+        Symbol& r = *rhs.symbols[i];
+        if (    l.Name() != r.Name()
+             || l.LinkFormat() != r.LinkFormat()
+             || memcmp(&l.RawItem(),&r.RawItem(),sizeof(Elf64_Sym)) != 0 )
+        {
+            log << "Symbol missmatch at " << i << endl;
+            log << l.LinkFormat() << " , " << r.LinkFormat() << endl;
+            return 1;
+        }
+    }
+
+    if ( lhs.symbolMap != rhs.symbolMap ) {
+        log << "Symbol name index missmatch" << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Build a minimal relocatable object in memory:
+ *
+ *  +-------------------------------+
+ *  | ELF File Header               |
+ *  +-------------------------------+
+ *  | .symtab                       |
+ *  +-------------------------------+
+ *  | .strtab                       |
+ *  +-------------------------------+
+ *  | .shstrtab                     |
+ *  +-------------------------------+
+ *  | Section headers               |
+ *  +-------------------------------+
+ */
+void BuildFile(DataVector& file, long count) {
+    const char shstrtab[] = "\0.symtab\0.strtab\0.shstrtab";
+    const long symtabName = 1;
+    const long strtabName = 9;
+    const long shstrtabName = 17;
+
+    // Symbol names: every 16th symbol is blank, and every so often we
+    // re-use a name to exercise the duplicate handling in the name index
+    string strtab(1,'\0');
+    vector<Elf64_Sym> symbols(count);
+    for ( long i=0; i< count; ++i ) {
+        Elf64_Sym& sym = symbols[i];
+        memset(&sym,0,sizeof(sym));
+        if ( i % 16 != 0 ) {
+            ostringstream name;
+            name << "symbol_" << (i % 1000 == 1 ? 1 : i);
+            sym.st_name = strtab.size();
+            strtab += name.str();
+            strtab += '\0';
+        }
+        sym.st_value = 0x400000 + i * 16;
+        sym.st_size = 16;
+        sym.st_info = ELF64_ST_INFO( i % 3 == 0 ? STB_GLOBAL : STB_LOCAL,
+                                     i % 2 == 0 ? STT_FUNC : STT_OBJECT);
+        sym.st_shndx = 1 + i % 3;
+    }
+
+    Elf64_Off symtabStart = sizeof(Elf64_Ehdr);
+    Elf64_Off strtabStart = symtabStart + count * sizeof(Elf64_Sym);
+    Elf64_Off shstrtabStart = strtabStart + strtab.size();
+    Elf64_Off headersStart = shstrtabStart + sizeof(shstrtab);
+    headersStart += 8 - headersStart % 8;
+
+    Elf64_Shdr headers[4];
+    memset(headers,0,sizeof(headers));
+
+    headers[1].sh_name = symtabName;
+    headers[1].sh_type = SHT_SYMTAB;
+    headers[1].sh_offset = symtabStart;
+    headers[1].sh_size = count * sizeof(Elf64_Sym);
+    headers[1].sh_link = 2;
+    headers[1].sh_entsize = sizeof(Elf64_Sym);
+    headers[1].sh_addralign = 8;
+
+    headers[2].sh_name = strtabName;
+    headers[2].sh_type = SHT_STRTAB;
+    headers[2].sh_offset = strtabStart;
+    headers[2].sh_size = strtab.size();
+    headers[2].sh_addralign = 1;
+
+    headers[3].sh_name = shstrtabName;
+    headers[3].sh_type = SHT_STRTAB;
+    headers[3].sh_offset = shstrtabStart;
+    headers[3].sh_size = sizeof(shstrtab);
+    headers[3].sh_addralign = 1;
+
+    ElfHeaderX86_64 header = ElfHeaderX86_64::NewObjectFile();
+    header.Sections() = 4;
+    header.SectionTableStart() = headersStart;
+    header.StringTableIndex() = 3;
+
+    file.Resize(headersStart + sizeof(headers));
+    file.Fill(0,'\0',file.Size());
+
+    BinaryWriter writer = file.Writer();
+    Elf64_Ehdr rawHeader;
+    header.GetHeader(rawHeader);
+    writer.Write(&rawHeader,sizeof(rawHeader));
+
+    (writer + symtabStart).Write(&symbols[0],count * sizeof(Elf64_Sym));
+    (writer + strtabStart).Write(strtab.c_str(),strtab.size());
+    (writer + shstrtabStart).Write(shstrtab,sizeof(shstrtab));
+    (writer + headersStart).Write(headers,sizeof(headers));
+}